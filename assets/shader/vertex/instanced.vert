@@ -0,0 +1,23 @@
+#version 450 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aColor;
+
+layout (std140, binding = 0) uniform FrameBlock
+{
+   mat4 view;
+   mat4 projection;
+   mat4 viewProjection;
+   float time;
+   float deltaTime;
+   float alpha;
+};
+
+out vec4 vColor;
+
+void main()
+{
+   vColor = aColor;
+   gl_Position = viewProjection * aModel * vec4(aPos, 1.0);
+}
@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "ecs/World.h"
+
+// Microbenchmark for component type ID resolution.
+// "legacy" reproduces the previous World::getComponentTypeID (mutex + std::type_index hash map)
+// so both paths can be compared on the same machine.
+
+namespace {
+
+struct BenchPosition { float x, y, z; };
+struct BenchVelocity { float x, y, z; };
+struct BenchHealth { int value; };
+struct BenchTag { int value; };
+
+std::unordered_map<std::type_index, ComponentID> s_legacyIDs;
+std::mutex s_legacyMutex;
+std::atomic<ComponentID> s_legacyNextID{ 1 };
+
+template<typename T>
+ComponentID legacyGetComponentTypeID() {
+    std::lock_guard<std::mutex> lock(s_legacyMutex);
+    std::type_index typeIndex = std::type_index(typeid(T));
+
+    auto it = s_legacyIDs.find(typeIndex);
+    if (it != s_legacyIDs.end()) {
+        return it->second;
+    }
+
+    ComponentID newID = s_legacyNextID.fetch_add(1, std::memory_order_relaxed);
+    s_legacyIDs[typeIndex] = newID;
+    return newID;
+}
+
+volatile ComponentID g_sink = 0;
+
+template<typename Func>
+double measureNsPerLookup(const char* label, size_t iterations, Func&& lookup) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        g_sink = lookup();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Each lookup() resolves four types.
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / (iterations * 4.0);
+    std::printf("%-10s %8.2f ns/lookup\n", label, ns);
+    return ns;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    double legacy = measureNsPerLookup("legacy", iterations, [] {
+        return legacyGetComponentTypeID<BenchPosition>() + legacyGetComponentTypeID<BenchVelocity>() +
+            legacyGetComponentTypeID<BenchHealth>() + legacyGetComponentTypeID<BenchTag>();
+    });
+
+    double current = measureNsPerLookup("current", iterations, [] {
+        return ComponentType<BenchPosition>::id() + ComponentType<BenchVelocity>::id() +
+            ComponentType<BenchHealth>::id() + ComponentType<BenchTag>::id();
+    });
+
+    std::printf("speedup    %8.1fx\n", legacy / current);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "pch.h"
+
+// Accumulator for a fixed-rate simulation driven by variable frame times. Each frame, advance() adds
+// the elapsed wall time and returns how many fixed steps to simulate; getAlpha() is how far the
+// remaining time reaches into the next step, for interpolating rendered state between the last two
+// steps. The number of steps per frame is capped, so a long stall drops time instead of spiralling.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double tickRate = 60.0, int maxStepsPerFrame = 5);
+
+    void setTickRate(double tickRate);
+    double getTickRate() const { return 1.0 / m_stepSeconds; }
+    float getStepSeconds() const { return static_cast<float>(m_stepSeconds); }
+
+    void setMaxStepsPerFrame(int maxSteps) { m_maxStepsPerFrame = std::max(maxSteps, 1); }
+    int getMaxStepsPerFrame() const { return m_maxStepsPerFrame; }
+
+    int advance(double elapsedSeconds);
+
+    float getAlpha() const { return static_cast<float>(m_accumulator / m_stepSeconds); }
+    // Total steps handed out by advance().
+    std::uint64_t getTickCount() const { return m_tickCount; }
+
+    // Discards pending time, e.g. after loading, so the next frame does not try to catch up on it.
+    void reset() { m_accumulator = 0.0; }
+
+private:
+    double m_stepSeconds;
+    int m_maxStepsPerFrame;
+    double m_accumulator = 0.0;
+    std::uint64_t m_tickCount = 0;
+};
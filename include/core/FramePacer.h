@@ -0,0 +1,27 @@
+#pragma once
+#include "pch.h"
+
+// Caps the frame rate without burning a core. wait() sleeps for most of the remaining frame time and
+// only yields through the final stretch, whose length tracks how far the OS has been overshooting
+// sleeps recently. Frames are scheduled on a fixed grid, so small overshoots do not accumulate.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A target of 0 disables the cap.
+    explicit FramePacer(double targetFrameRate = 0.0);
+
+    void setTargetFrameRate(double targetFrameRate);
+    double getTargetFrameRate() const { return m_targetFrameRate; }
+
+    // Blocks until the next frame is due.
+    void wait();
+    // Starts the frame grid at the current time.
+    void reset() { m_nextFrame = Clock::now() + m_frameDuration; }
+
+private:
+    double m_targetFrameRate = 0.0;
+    Clock::duration m_frameDuration{ 0 };
+    Clock::time_point m_nextFrame;
+    Clock::duration m_sleepOvershoot = std::chrono::microseconds(250);
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include "pch.h"
+
+// A work-stealing thread pool. Every thread owns a queue; it pops its own jobs LIFO and, when it runs
+// dry, steals FIFO from the other queues. Threads that are not pool workers (e.g. the main thread)
+// share queue 0 and help execute jobs while they wait.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+    using JobCounter = std::atomic<size_t>;
+
+    // workerCount == 0 uses one worker per hardware thread, minus the calling thread.
+    explicit JobSystem(size_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Number of threads that execute jobs, including the thread that waits on them.
+    size_t getThreadCount() const { return m_queues.size(); }
+
+    // Queue index of the calling thread: its worker index, or 0 for threads outside the pool.
+    size_t getCurrentThreadIndex() const;
+
+    // Schedules `job` on the calling thread's queue, where idle threads may steal it.
+    // `counter` is incremented immediately and decremented once the job has finished.
+    void submit(Job job, JobCounter& counter);
+
+    // Schedules `job` on a fixed thread. Pinned jobs are never stolen and run in submission order.
+    void submitTo(size_t threadIndex, Job job, JobCounter& counter);
+
+    // Executes pending jobs on the calling thread until `counter` drops to zero.
+    void wait(const JobCounter& counter);
+
+    // Calls func(begin, end) over [0, count) in chunks of `grainSize` and blocks until all are done.
+    // The chunk bounds depend only on `count` and `grainSize`; which thread runs a chunk, and when, does not.
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func);
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::deque<Task> pinned;
+    };
+
+    void workerLoop(size_t threadIndex);
+    bool runOne(size_t threadIndex);
+    void execute(Task& task);
+    void notifyWorkers();
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<size_t> m_queuedTasks{ 0 };
+    std::atomic<bool> m_stop{ false };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    static thread_local const JobSystem* t_owner;
+    static thread_local size_t t_threadIndex;
+};
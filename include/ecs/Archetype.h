@@ -0,0 +1,149 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/Component.h"
+#include "ecs/ComponentMask.h"
+
+// Type-homogeneous, type-erased storage for one component type inside an archetype.
+// Elements are laid out contiguously in a raw buffer and manipulated through ComponentTypeInfo.
+// Each row carries added/changed ticks; the column keeps the newest of them so unchanged columns can be
+// skipped without looking at individual rows.
+class ComponentColumn {
+public:
+    explicit ComponentColumn(const ComponentTypeInfo& info) : m_info(&info) {}
+    ~ComponentColumn();
+
+    ComponentColumn(const ComponentColumn&) = delete;
+    ComponentColumn& operator=(const ComponentColumn&) = delete;
+    ComponentColumn(ComponentColumn&& other) noexcept;
+    ComponentColumn& operator=(ComponentColumn&& other) noexcept;
+
+    const ComponentTypeInfo& getTypeInfo() const { return *m_info; }
+
+    // Appends the element at `row` and its ticks to `dst` (which must hold the same type), leaving a
+    // moved-from value behind.
+    void moveElementTo(size_t row, ComponentColumn& dst);
+    void swapRemove(size_t row);
+
+    size_t size() const { return m_size; }
+    void reserve(size_t capacity);
+
+    // Grows the column by `count` rows stamped as added at `tick` and returns the first of them.
+    // The caller must construct every new element before the column is used again.
+    void* appendUninitialized(size_t count, Tick tick);
+    void clear();
+
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        void* slot = pushUninitialized();
+        constructComponent<T>(slot, std::forward<Args>(args)...);
+        return *static_cast<T*>(slot);
+    }
+
+    void* get(size_t row) { return m_data + row * m_info->size; }
+    const void* get(size_t row) const { return m_data + row * m_info->size; }
+
+    template<typename T>
+    T* data() { return reinterpret_cast<T*>(m_data); }
+
+    template<typename T>
+    const T* data() const { return reinterpret_cast<const T*>(m_data); }
+
+    ComponentTicks* ticks() { return m_ticks.data(); }
+    const ComponentTicks* ticks() const { return m_ticks.data(); }
+    const ComponentTicks& getColumnTicks() const { return m_columnTicks; }
+
+    void markAdded(size_t row, Tick tick) {
+        m_ticks[row] = ComponentTicks{ tick, tick };
+        m_columnTicks = ComponentTicks{ tick, tick };
+    }
+
+    void markChanged(size_t row, Tick tick) {
+        m_ticks[row].changed = tick;
+        m_columnTicks.changed = tick;
+    }
+
+    // Raises the column-level changed tick only; callers stamp the individual rows themselves.
+    void markColumnChanged(Tick tick) { m_columnTicks.changed = tick; }
+
+private:
+    void* pushUninitialized();
+    void relocate(void* dst, void* src) const;
+
+    const ComponentTypeInfo* m_info;
+    std::byte* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+
+    std::vector<ComponentTicks> m_ticks;
+    ComponentTicks m_columnTicks;
+};
+
+// A table holding every entity whose component mask is exactly `getMask()`.
+// Each component type lives in its own contiguous column; row `i` of every column belongs to `getEntities()[i]`.
+class Archetype {
+public:
+    explicit Archetype(const ComponentMask& mask) : m_mask(mask) {
+        m_columnIndex.fill(-1);
+    }
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    const ComponentMask& getMask() const { return m_mask; }
+    const std::vector<EntityID>& getEntities() const { return m_entities; }
+    size_t size() const { return m_entities.size(); }
+    bool empty() const { return m_entities.empty(); }
+
+    void addColumn(ComponentID typeID, const ComponentTypeInfo& info);
+
+    bool hasColumn(ComponentID typeID) const {
+        return typeID < m_columnIndex.size() && m_columnIndex[typeID] >= 0;
+    }
+
+    ComponentColumn* getColumn(ComponentID typeID) {
+        return hasColumn(typeID) ? &m_columns[m_columnIndex[typeID]] : nullptr;
+    }
+
+    const ComponentColumn* getColumn(ComponentID typeID) const {
+        return hasColumn(typeID) ? &m_columns[m_columnIndex[typeID]] : nullptr;
+    }
+
+    // Creates an archetype with the same columns as this one, plus or minus the given component.
+    // Tags only change the mask.
+    std::unique_ptr<Archetype> createWith(ComponentID typeID, const ComponentTypeInfo& info) const;
+    std::unique_ptr<Archetype> createWithout(ComponentID typeID) const;
+
+    // Appends an entity row. Columns must be filled by the caller afterwards.
+    size_t pushEntity(EntityID entityID);
+
+    // Appends `count` rows at once and returns their entity slots for the caller to write. Columns must
+    // be filled by the caller afterwards.
+    EntityID* appendRows(size_t count);
+
+    // Moves the row into `dst`, transferring the columns both archetypes share. Columns only present
+    // in `dst` are left for the caller to fill. Returns the entity that was swapped into `row`, or NULL_ENTITY_ID.
+    EntityID moveRowTo(size_t row, Archetype& dst);
+
+    // Swap-and-pop removal. Returns the entity that was swapped into `row`, or NULL_ENTITY_ID.
+    EntityID removeRow(size_t row);
+
+    void reserve(size_t capacity);
+    void clear();
+
+    Archetype* getAddEdge(ComponentID typeID) const;
+    Archetype* getRemoveEdge(ComponentID typeID) const;
+    void setAddEdge(ComponentID typeID, Archetype* archetype) { m_addEdges[typeID] = archetype; }
+    void setRemoveEdge(ComponentID typeID, Archetype* archetype) { m_removeEdges[typeID] = archetype; }
+
+private:
+    ComponentMask m_mask;
+    std::vector<EntityID> m_entities;
+
+    std::vector<ComponentID> m_columnTypes;
+    std::vector<ComponentColumn> m_columns;
+    std::array<std::int16_t, ComponentMask::MAX_COMPONENTS> m_columnIndex;
+
+    std::unordered_map<ComponentID, Archetype*> m_addEdges;
+    std::unordered_map<ComponentID, Archetype*> m_removeEdges;
+};
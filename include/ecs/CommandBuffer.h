@@ -0,0 +1,125 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/Component.h"
+#include "ecs/World.h"
+#include "core/JobSystem.h"
+
+// Records structural changes (create, destroy, add, remove) so they can be made while the World is
+// being iterated, including from job-system workers. Each worker of the World's JobSystem records into
+// its own stream without locking; all other threads, including the one calling World::update, share
+// one stream behind a mutex. Chunks of a deterministic World::parallelFor record into a stream of their
+// own instead, so their commands do not depend on which thread ran them. playback() applies everything
+// in one pass at a sync point, grouped by entity and in recording order per stream: thread streams
+// first, then chunk streams in dispatch and chunk order.
+class CommandBuffer {
+public:
+    explicit CommandBuffer(World& world);
+    ~CommandBuffer();
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // Returns a reserved handle that is usable in later commands right away. The entity itself becomes
+    // live at the World's next flush, even if this buffer is cleared without being played back.
+    EntityID create();
+
+    void destroy(EntityID entityID);
+
+    template<typename T, typename... Args>
+    void add(EntityID entityID, Args&&... args);
+
+    template<typename T>
+    void remove(EntityID entityID);
+
+    bool empty() const;
+
+    // Applies and clears every recorded command. Must be called while no system is iterating the World.
+    void playback();
+
+    // Drops every recorded command without applying it.
+    void clear();
+
+private:
+    enum class CommandType : std::uint8_t {
+        Destroy,
+        Add,
+        Remove
+    };
+
+    using ApplyFunc = void(*)(World& world, EntityID entityID, void* payload);
+
+    struct Command {
+        CommandType type;
+        EntityID entityID;
+        ApplyFunc apply;
+        void* payload;
+        const ComponentTypeInfo* payloadInfo;
+    };
+
+    static constexpr size_t PAYLOAD_BLOCK_SIZE = 16 * 1024;
+
+    // Payloads live in fixed blocks so recorded pointers stay valid while the stream grows. Blocks are
+    // kept across playbacks and reused.
+    struct Stream {
+        std::vector<Command> commands;
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::vector<std::unique_ptr<std::byte[]>> largeBlocks;
+        size_t blockCount = 0;
+        size_t blockUsed = 0;
+
+        void* allocate(size_t size, size_t alignment);
+    };
+
+    // Returns the calling thread's stream. For the shared stream, `lock` is locked on return.
+    Stream& lockStream(std::unique_lock<std::mutex>& lock);
+
+    // Makes room for one stream per thread of a JobSystem with `threadCount` threads. Called by the World
+    // whenever its JobSystem changes, never while commands are being recorded.
+    void reserveStreams(size_t threadCount);
+
+    // Claims `count` chunk streams for one deterministic parallelFor, in chunk order.
+    std::vector<Stream*> reserveChunkStreams(size_t count);
+    void clearStream(Stream& stream);
+    friend class World;
+
+    // The chunk stream that commands recorded on this thread go to, while a deterministic chunk runs.
+    static inline thread_local Stream* t_chunkStream = nullptr;
+    static inline thread_local const CommandBuffer* t_chunkBuffer = nullptr;
+
+    World& m_world;
+    // Stream i belongs to worker i of the World's JobSystem; stream 0 is the shared one.
+    std::vector<Stream> m_streams;
+    std::mutex m_sharedStreamMutex;
+
+    // Chunk streams are kept and reused like the thread streams; a deque, so claiming more never moves
+    // streams other chunks are recording into.
+    std::deque<Stream> m_chunkStreams;
+    size_t m_chunkStreamCount = 0;
+    std::mutex m_chunkStreamMutex;
+};
+
+template<typename T, typename... Args>
+void CommandBuffer::add(EntityID entityID, Args&&... args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components cannot be recorded");
+
+    std::unique_lock<std::mutex> lock(m_sharedStreamMutex, std::defer_lock);
+    Stream& stream = lockStream(lock);
+    void* payload = stream.allocate(sizeof(T), alignof(T));
+    constructComponent<T>(payload, std::forward<Args>(args)...);
+
+    ApplyFunc apply = [](World& world, EntityID target, void* data) {
+        T& value = *static_cast<T*>(data);
+        world.addComponent<T>(target, std::move(value));
+    };
+    stream.commands.push_back(Command{ CommandType::Add, entityID, apply, payload, &getComponentTypeInfo<T>() });
+}
+
+template<typename T>
+void CommandBuffer::remove(EntityID entityID) {
+    ApplyFunc apply = [](World& world, EntityID target, void*) {
+        world.removeComponent<T>(target);
+    };
+    std::unique_lock<std::mutex> lock(m_sharedStreamMutex, std::defer_lock);
+    lockStream(lock).commands.push_back(Command{ CommandType::Remove, entityID, apply, nullptr, nullptr });
+}
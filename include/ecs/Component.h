@@ -7,50 +7,130 @@ using ComponentID = std::uint32_t;
 
 inline constexpr ComponentID NULL_COMPONENT_TYPE = 0;
 
-struct IComponent {
-    virtual ~IComponent() = default;
+// World change counter. Every system run and every update phase gets its own tick, and component
+// writes are stamped with the tick current at the time, so "changed after tick N" is a plain comparison.
+using Tick = std::uint32_t;
+
+struct ComponentTicks {
+    Tick added = 0;
+    Tick changed = 0;
 };
 
-class ComponentTypeIDAllocator {
-public:
-    static ComponentID allocate() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_freedIDs.empty()) {
-            ComponentID id = m_freedIDs.back();
-            m_freedIDs.pop_back();
-            return id;
-        }
-        return m_nextID.fetch_add(1, std::memory_order_relaxed);
-    }
+// Where a component type's data lives. Table components are stored in archetype columns and are the
+// fastest to iterate; SparseSet components live in a per-type pool so adding and removing them never
+// moves the entity between archetypes. A component opts in with a static member:
+//     static constexpr ComponentStorage Storage = ComponentStorage::SparseSet;
+enum class ComponentStorage {
+    Table,
+    SparseSet
+};
 
-    static void deallocate(ComponentID id) {
-        if (id != NULL_COMPONENT_TYPE) {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_freedIDs.push_back(id);
-        }
-    }
-private:
-    static inline std::atomic<ComponentID> m_nextID{ 1 };
-    static inline std::vector<ComponentID> m_freedIDs;
-    static inline std::mutex m_mutex;
+template<typename T, typename = void>
+struct ComponentStorageOf {
+    static constexpr ComponentStorage value = ComponentStorage::Table;
 };
 
-class ComponentManager {
-public:
-    template<typename T, typename... Args>
-    T& addComponent(EntityID entityID, Args&&... args);
+template<typename T>
+struct ComponentStorageOf<T, std::void_t<decltype(T::Storage)>> {
+    static constexpr ComponentStorage value = T::Storage;
+};
+
+template<typename T>
+inline constexpr bool isSparseComponent = ComponentStorageOf<T>::value == ComponentStorage::SparseSet;
+
+// Empty table components are tags: they only set a bit in the archetype mask and get no column.
+// Queries hand out a reference to a shared instance for them.
+template<typename T>
+inline constexpr bool isTagComponent = std::is_empty_v<std::remove_cv_t<T>> && !isSparseComponent<T>;
+
+template<typename T>
+T& getTagInstance() {
+    static_assert(std::is_empty_v<std::remove_cv_t<T>>, "Only empty types are tags");
+    static std::remove_cv_t<T> s_instance{};
+    return s_instance;
+}
+
+// Components are plain structs. Aggregates are brace-initialised so `addComponent<Position>(e, 1.0f, 2.0f)`
+// works without a hand-written constructor.
+template<typename T, typename... Args>
+void constructComponent(void* dst, Args&&... args) {
+    if constexpr (std::is_aggregate_v<T> && !std::is_constructible_v<T, Args...>) {
+        new (dst) T{ std::forward<Args>(args)... };
+    }
+    else {
+        new (dst) T(std::forward<Args>(args)...);
+    }
+}
+
+template<typename T, typename... Args>
+T makeComponent(Args&&... args) {
+    if constexpr (std::is_aggregate_v<T> && !std::is_constructible_v<T, Args...>) {
+        return T{ std::forward<Args>(args)... };
+    }
+    else {
+        return T(std::forward<Args>(args)...);
+    }
+}
 
-    template<typename T>
-    T& getComponent(EntityID entityID);
+// Type-erased description of a component type, generated once per type at compile time.
+// Trivially copyable types are relocated with memcpy; everything else goes through the thunks.
+struct ComponentTypeInfo {
+    size_t size;
+    size_t alignment;
+    bool trivial;
+    bool tag;
+    void (*moveConstruct)(void* dst, void* src);
+    void (*destroy)(void* ptr);
+    const char* name;
+};
 
-    template<typename T>
-    void removeComponent(EntityID entityID);
+template<typename T>
+const ComponentTypeInfo& getComponentTypeInfo() {
+    static_assert(std::is_move_constructible_v<T>, "Components must be move constructible");
+    static_assert(std::is_destructible_v<T>, "Components must be destructible");
 
-    template<typename T>
-    bool hasComponent(EntityID entityID) const;
+    static const ComponentTypeInfo info{
+        sizeof(T),
+        alignof(T),
+        std::is_trivially_copyable_v<T>,
+        isTagComponent<T>,
+        [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+        [](void* ptr) { static_cast<T*>(ptr)->~T(); },
+        typeid(T).name()
+    };
+    return info;
+}
 
+// Component type IDs identify C++ types, so they are deliberately process-wide: every World agrees on
+// them and masks can be compared across worlds. Each type allocates exactly once, so a plain atomic
+// counter is enough and IDs are never recycled. Running out of IDs is a hard error rather than a type
+// that silently never matches.
+class ComponentTypeIDAllocator {
+public:
+    static ComponentID allocate(const char* typeName) {
+        ComponentID id = s_nextID.fetch_add(1, std::memory_order_relaxed);
+        if (id >= ComponentMask::MAX_COMPONENTS) {
+            LOG_ERROR("ComponentTypeIDAllocator::allocate: Component type '{}' exceeds the limit of {} component types.",
+                typeName, ComponentMask::MAX_COMPONENTS);
+            throw std::length_error("ComponentTypeIDAllocator: too many component types");
+        }
+        return id;
+    }
 private:
-    std::unordered_map<EntityID, std::unordered_map<ComponentID, std::unique_ptr<IComponent>>> m_components;
+    static inline std::atomic<ComponentID> s_nextID{ 1 };
+};
 
-    std::unordered_map<EntityID, ComponentMask> m_entityMasks;
-};
\ No newline at end of file
+// Resolves a component type's ID once, on first use; afterwards every lookup is a single guarded
+// load with no lock and no hashing. cv-qualifiers are stripped so `const T` shares T's ID.
+template<typename T>
+struct ComponentType {
+    static ComponentID id() {
+        if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>) {
+            return ComponentType<std::remove_cv_t<T>>::id();
+        }
+        else {
+            static const ComponentID s_id = ComponentTypeIDAllocator::allocate(typeid(T).name());
+            return s_id;
+        }
+    }
+};
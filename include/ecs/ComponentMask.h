@@ -2,13 +2,19 @@
 #include "pch.h"
 
 
-struct IComponent;
 using ComponentID = std::uint32_t;
 
 
+// A fixed-width bit set over component type IDs, stored as plain 64-bit words so that matches() and
+// friends are a short, branch-free loop the compiler unrolls and vectorises.
 class ComponentMask {
 public:
-    static constexpr size_t MAX_COMPONENTS = 64;
+    // Upper bound on distinct component types per process; also sizes archetype column tables.
+    static constexpr size_t MAX_COMPONENTS = 256;
+    static constexpr size_t WORD_BITS = 64;
+    static constexpr size_t WORD_COUNT = (MAX_COMPONENTS + WORD_BITS - 1) / WORD_BITS;
+
+    using Word = std::uint64_t;
 
     ComponentMask() = default;
 
@@ -21,25 +27,85 @@ public:
     template<typename T>
     bool has() const;
 
+    // IDs come from ComponentTypeIDAllocator, which never hands out one at or above MAX_COMPONENTS.
+    void set(ComponentID id) {
+        assert(id < MAX_COMPONENTS);
+        m_words[id / WORD_BITS] |= Word(1) << (id % WORD_BITS);
+    }
+
+    void reset(ComponentID id) {
+        assert(id < MAX_COMPONENTS);
+        m_words[id / WORD_BITS] &= ~(Word(1) << (id % WORD_BITS));
+    }
+
+    bool test(ComponentID id) const {
+        return id < MAX_COMPONENTS && (m_words[id / WORD_BITS] >> (id % WORD_BITS)) & 1;
+    }
+
+    // True if every bit of `other` is also set here.
     bool matches(const ComponentMask& other) const {
-        return (m_mask & other.m_mask) == other.m_mask;
+        Word missing = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            missing |= other.m_words[i] & ~m_words[i];
+        }
+        return missing == 0;
+    }
+
+    bool intersects(const ComponentMask& other) const {
+        Word common = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            common |= m_words[i] & other.m_words[i];
+        }
+        return common != 0;
+    }
+
+    ComponentMask& operator|=(const ComponentMask& other) {
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            m_words[i] |= other.m_words[i];
+        }
+        return *this;
     }
 
     void clear() {
-        m_mask.reset();
+        m_words.fill(0);
     }
 
     bool empty() const {
-        return m_mask.none();
+        Word any = 0;
+        for (Word word : m_words) {
+            any |= word;
+        }
+        return any == 0;
+    }
+
+    const std::array<Word, WORD_COUNT>& getWords() const {
+        return m_words;
+    }
+
+    bool operator==(const ComponentMask& other) const {
+        return m_words == other.m_words;
     }
 
-    const std::bitset<MAX_COMPONENTS>& getBitset() const {
-        return m_mask;
+    bool operator!=(const ComponentMask& other) const {
+        return m_words != other.m_words;
     }
 
 private:
-    std::bitset<MAX_COMPONENTS> m_mask;
+    std::array<Word, WORD_COUNT> m_words{};
 
     template<typename T>
     static ComponentID getComponentTypeID();
 };
+
+namespace std {
+    template<>
+    struct hash<ComponentMask> {
+        size_t operator()(const ComponentMask& mask) const noexcept {
+            size_t seed = 0;
+            for (ComponentMask::Word word : mask.getWords()) {
+                seed ^= hash<ComponentMask::Word>{}(word) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+}
@@ -1,44 +1,23 @@
 #pragma once
 #include "pch.h"
 
-using EntityID = std::uint32_t;
+// An entity handle packs a slot index (low 32 bits) with the slot's generation (high 32 bits).
+// Destroying an entity bumps its slot's generation, so stale handles never alias a recycled slot.
+using EntityID = std::uint64_t;
+using EntityIndex = std::uint32_t;
+using EntityGeneration = std::uint32_t;
 
+// Slot 0 is never handed out, so the all-zero handle is always invalid.
 inline constexpr EntityID NULL_ENTITY_ID = 0;
 
-class EntityIDAllocator {
-public:
-    static EntityID allocate() {
-        {
-            std::lock_guard<std::mutex> lock(s_mutex);
-            if (!s_freedIDs.empty()) {
-                EntityID id = s_freedIDs.back();
-                s_freedIDs.pop_back();
-                return id;
-            }
-        }
-        return s_nextID.fetch_add(1, std::memory_order_relaxed);
-    }
+inline constexpr EntityID makeEntityID(EntityIndex index, EntityGeneration generation) {
+    return (static_cast<EntityID>(generation) << 32) | index;
+}
 
-    static void deallocate(EntityID id) {
-        if (id != NULL_ENTITY_ID) {
-            std::lock_guard<std::mutex> lock(s_mutex);
-            s_freedIDs.push_back(id);
-        }
-    }
-private:
-    static inline std::atomic<EntityID> s_nextID{ 1 };
-    static inline std::vector<EntityID> s_freedIDs;
-    static inline std::mutex s_mutex;
+inline constexpr EntityIndex getEntityIndex(EntityID entityID) {
+    return static_cast<EntityIndex>(entityID);
+}
 
-};
-
-class EntityManager {
-public:
-    EntityID createEntity();
-    void DestroyEntity(EntityID entityID);
-    bool isValidEntity(EntityID entityID) const;
-    const std::unordered_set<EntityID>& getAllEntities() const { return m_entities; }
-
-private:
-    std::unordered_set<EntityID> m_entities;
-};
+inline constexpr EntityGeneration getEntityGeneration(EntityID entityID) {
+    return static_cast<EntityGeneration>(entityID >> 32);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "pch.h"
+#include <gtc/quaternion.hpp>
+#include "ecs/Entity.h"
+#include "ecs/Snapshot.h"
+
+class World;
+
+// Parent / child links. Both sides are kept in sync by the Hierarchy helpers below; editing them by
+// hand is not supported.
+struct Parent {
+    EntityID entity = NULL_ENTITY_ID;
+};
+
+struct Children {
+    std::vector<EntityID> entities;
+};
+
+template<>
+struct ComponentSerializer<Children> {
+    static void write(SnapshotWriter& out, const Children& value) { out.writeVector(value.entities); }
+
+    static Children read(SnapshotReader& in) {
+        Children value;
+        in.readVector(value.entities);
+        return value;
+    }
+};
+
+// Transform relative to the parent, or to the world for roots.
+struct LocalTransform {
+    glm::vec3 position{ 0.0f };
+    glm::quat rotation = glm::identity<glm::quat>();
+    glm::vec3 scale{ 1.0f };
+
+    glm::mat4 getMatrix() const {
+        glm::mat4 matrix = glm::mat4_cast(rotation);
+        matrix[0] *= scale.x;
+        matrix[1] *= scale.y;
+        matrix[2] *= scale.z;
+        matrix[3] = glm::vec4(position, 1.0f);
+        return matrix;
+    }
+};
+
+// Written by TransformSystem from the LocalTransforms of the entity and all of its ancestors.
+struct WorldTransform {
+    glm::mat4 matrix{ 1.0f };
+};
+
+// Structural helpers for the hierarchy. These add and remove components, so they must not be called
+// while a system iterates the World concurrently.
+class Hierarchy {
+public:
+    // Attaches `child` to `parent`, detaching it from its previous parent first. Fails (and logs) if
+    // either entity is invalid or `parent` is `child` or one of its descendants.
+    static bool setParent(World& world, EntityID child, EntityID parent);
+
+    // Turns `child` into a root. Its own children stay attached to it.
+    static void removeParent(World& world, EntityID child);
+
+    static EntityID getParent(const World& world, EntityID entityID);
+
+    // Destroys `entityID` together with all of its descendants.
+    static void destroyRecursive(World& world, EntityID entityID);
+
+    // Registers Parent, Children and the transform components with SnapshotRegistry.
+    static void registerSnapshotComponents();
+
+private:
+    // Removes `child` from its current parent's Children. The possibly empty Children component is kept,
+    // so TransformSystem still sees the change through its tick.
+    static void detachFromParent(World& world, EntityID child);
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/Component.h"
+#include "ecs/ComponentMask.h"
+#include "ecs/Archetype.h"
+#include "core/JobSystem.h"
+
+class World;
+
+// Mask and matching-archetype cache shared by every Query instantiation. The owning World calls
+// onArchetypeCreated() whenever a new archetype appears, so the cache never has to be rebuilt.
+class QueryBase {
+public:
+    explicit QueryBase(const ComponentMask& tableMask) : m_tableMask(tableMask) {}
+    virtual ~QueryBase() = default;
+
+    QueryBase(const QueryBase&) = delete;
+    QueryBase& operator=(const QueryBase&) = delete;
+
+    const ComponentMask& getTableMask() const { return m_tableMask; }
+    const std::vector<Archetype*>& getArchetypes() const { return m_archetypes; }
+
+    void onArchetypeCreated(Archetype* archetype) {
+        if (archetype->getMask().matches(m_tableMask)) {
+            m_archetypes.push_back(archetype);
+        }
+    }
+
+protected:
+    ComponentMask m_tableMask;
+    std::vector<Archetype*> m_archetypes;
+};
+
+// Query filters. Passed as the first argument of Query::forEach, they restrict iteration to entities
+// whose T was added (Added) or added or written (Changed) after `since`, usually the calling system's
+// ISystem::getLastRunTick(). Whole archetypes are skipped when their column has nothing newer.
+template<typename T>
+struct Added {
+    using Component = std::remove_cv_t<T>;
+    Tick since = 0;
+
+    bool matches(const ComponentTicks& ticks) const { return ticks.added > since; }
+};
+
+template<typename T>
+struct Changed {
+    using Component = std::remove_cv_t<T>;
+    Tick since = 0;
+
+    bool matches(const ComponentTicks& ticks) const { return ticks.changed > since; }
+};
+
+// The filter used by the unfiltered forEach overloads; accepts every entity.
+struct NoFilter {};
+
+// A pre-compiled view over every entity that has all of `Components`. Obtain one through
+// World::query<Components...>(); the reference stays valid for the lifetime of the World, so systems
+// can resolve it once and iterate it every frame at a cost proportional to the matching entities only.
+template<typename... Components>
+class Query : public QueryBase {
+public:
+    static_assert(sizeof...(Components) > 0, "A query needs at least one component");
+
+    explicit Query(World& world);
+
+    template<typename Func>
+    void forEach(Func&& func);
+
+    template<typename Func>
+    void forEach(Func&& func) const;
+
+    // Visits only the entities accepted by `filter` (an Added<T> or Changed<T>).
+    template<typename Filter, typename Func>
+    void forEach(const Filter& filter, Func&& func);
+
+    template<typename Filter, typename Func>
+    void forEach(const Filter& filter, Func&& func) const;
+
+    // Like forEach, but splits the matching entities into cache-sized chunks and runs them on `jobs`.
+    // `func` may run concurrently for different entities, so it must not create or destroy entities
+    // or add or remove components.
+    template<typename Func>
+    void parallelForEach(JobSystem& jobs, Func&& func, bool deterministic = false);
+
+    std::vector<EntityID> getEntities() const;
+    size_t size() const;
+
+    // Target working set per parallel chunk, roughly one L1 data cache.
+    static constexpr size_t PARALLEL_CHUNK_BYTES = 32 * 1024;
+    static constexpr size_t PARALLEL_CHUNK_ROWS =
+        std::max<size_t>(PARALLEL_CHUNK_BYTES / (sizeof(EntityID) + (sizeof(Components) + ...)), 16);
+
+private:
+    static constexpr bool HAS_SPARSE = (isSparseComponent<Components> || ...);
+
+    // Non-const component types are written through, so iterating them stamps the visited rows as changed.
+    static constexpr bool HAS_WRITES = (!std::is_const_v<Components> || ...);
+
+    template<typename Filter, typename Func>
+    void each(const Filter& filter, Func&& func);
+
+    template<typename Filter, typename Func>
+    void each(const Filter& filter, Func&& func) const;
+
+    // Tick array the filter is evaluated against for rows of `archetype`, or nullptr if nothing in it can match.
+    template<typename Filter>
+    const ComponentTicks* getFilterTicks(const Filter& filter, const Archetype& archetype) const;
+
+    template<typename Filter>
+    bool matchesRow(const Filter& filter, const ComponentTicks* ticks, EntityID entityID, size_t row) const;
+
+    template<size_t... I>
+    std::array<ComponentTicks*, sizeof...(Components)> getWriteTicks(Archetype& archetype, std::index_sequence<I...>) const;
+
+    void markColumnsChanged(Archetype& archetype, Tick tick) const;
+
+    // Tags have no column; their "column" is null and rowOf() resolves every row to the shared instance.
+    template<typename T, typename ArchetypeT>
+    static auto* getColumnData(ArchetypeT& archetype, ComponentID typeID) {
+        if constexpr (isTagComponent<T>) {
+            return static_cast<T*>(nullptr);
+        }
+        else {
+            return archetype.getColumn(typeID)->template data<std::remove_const_t<T>>();
+        }
+    }
+
+    template<typename T>
+    static T& rowOf(T* data, size_t row) {
+        if constexpr (isTagComponent<T>) {
+            return getTagInstance<T>();
+        }
+        else {
+            return data[row];
+        }
+    }
+
+    template<size_t... I>
+    std::tuple<Components*...> getColumns(Archetype& archetype, std::index_sequence<I...>) const;
+
+    template<size_t... I>
+    std::tuple<const Components*...> getColumns(const Archetype& archetype, std::index_sequence<I...>) const;
+
+    World* m_world;
+    std::array<ComponentID, sizeof...(Components)> m_typeIDs;
+};
+
+// Assigns every distinct Query<...> instantiation a dense index so a World can cache its queries
+// in a plain vector.
+class QueryTypeIDAllocator {
+public:
+    static size_t allocate() {
+        return s_nextID.fetch_add(1, std::memory_order_relaxed);
+    }
+private:
+    static inline std::atomic<size_t> s_nextID{ 0 };
+};
+
+template<typename... Components>
+struct QueryType {
+    static size_t id() {
+        static const size_t s_id = QueryTypeIDAllocator::allocate();
+        return s_id;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include "pch.h"
+
+// Assigns every resource type a dense index so a World can keep its resources in a plain vector.
+// Resource IDs are separate from component type IDs and never take up component mask bits.
+class ResourceTypeIDAllocator {
+public:
+    static size_t allocate() {
+        return s_nextID.fetch_add(1, std::memory_order_relaxed);
+    }
+private:
+    static inline std::atomic<size_t> s_nextID{ 0 };
+};
+
+template<typename T>
+struct ResourceType {
+    static size_t id() {
+        static const size_t s_id = ResourceTypeIDAllocator::allocate();
+        return s_id;
+    }
+};
@@ -0,0 +1,220 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/Component.h"
+
+class World;
+
+// Append-only byte buffer that World::writeSnapshot and ComponentSerializer specialisations write into.
+// Values are stored in native byte order and layout, so snapshots are only portable between builds of
+// the same platform.
+class SnapshotWriter {
+public:
+    void writeBytes(const void* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        size_t offset = m_buffer.size();
+        m_buffer.resize(offset + size);
+        std::memcpy(m_buffer.data() + offset, data, size);
+    }
+
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written directly");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(std::string_view value) {
+        write(static_cast<std::uint32_t>(value.size()));
+        writeBytes(value.data(), value.size());
+    }
+
+    template<typename T>
+    void writeVector(const std::vector<T>& values) {
+        write(static_cast<std::uint32_t>(values.size()));
+        writeBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    // Writes a placeholder for a T and returns its offset, to be filled in with patch() once known.
+    template<typename T>
+    size_t reserve() {
+        size_t offset = m_buffer.size();
+        m_buffer.resize(offset + sizeof(T));
+        return offset;
+    }
+
+    template<typename T>
+    void patch(size_t offset, const T& value) {
+        std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+    }
+
+    size_t size() const { return m_buffer.size(); }
+    const std::vector<std::byte>& getBuffer() const { return m_buffer; }
+    std::vector<std::byte> release() { return std::move(m_buffer); }
+
+private:
+    std::vector<std::byte> m_buffer;
+};
+
+// Bounds-checked cursor over snapshot bytes, typically a MappedFile. Reading past the end sets failed()
+// and yields zeroed values instead of throwing, so callers can check once after a batch of reads.
+class SnapshotReader {
+public:
+    SnapshotReader(const std::byte* data, size_t size) : m_data(data), m_size(size) {}
+
+    // Returns the next `size` bytes and skips them, or nullptr if the data ends early.
+    const std::byte* readBlock(size_t size) {
+        if (m_failed || size > m_size - m_offset) {
+            m_failed = true;
+            return nullptr;
+        }
+        const std::byte* block = m_data + m_offset;
+        m_offset += size;
+        return block;
+    }
+
+    bool readBytes(void* dst, size_t size) {
+        const std::byte* block = readBlock(size);
+        if (!block) {
+            std::memset(dst, 0, size);
+            return false;
+        }
+        if (size > 0) {
+            std::memcpy(dst, block, size);
+        }
+        return true;
+    }
+
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read directly");
+        T value;
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    std::string readString() {
+        std::uint32_t length = read<std::uint32_t>();
+        const std::byte* block = readBlock(length);
+        return block ? std::string(reinterpret_cast<const char*>(block), length) : std::string();
+    }
+
+    template<typename T>
+    bool readVector(std::vector<T>& values) {
+        std::uint32_t count = read<std::uint32_t>();
+        if (m_failed || count > remaining() / std::max<size_t>(sizeof(T), 1)) {
+            m_failed = true;
+            values.clear();
+            return false;
+        }
+        values.resize(count);
+        return readBytes(values.data(), count * sizeof(T));
+    }
+
+    bool skip(size_t size) { return readBlock(size) != nullptr; }
+
+    bool failed() const { return m_failed; }
+    size_t remaining() const { return m_size - m_offset; }
+
+private:
+    const std::byte* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+// Reflection hook for components that are not trivially copyable. Trivially copyable components are
+// written as raw column blocks and need nothing; anything else must specialise this with
+//     static void write(SnapshotWriter& out, const T& value);
+//     static T read(SnapshotReader& in);
+template<typename T>
+struct ComponentSerializer {};
+
+template<typename T, typename = void>
+inline constexpr bool hasComponentSerializer = false;
+
+template<typename T>
+inline constexpr bool hasComponentSerializer<T, std::void_t<decltype(&ComponentSerializer<T>::write), decltype(&ComponentSerializer<T>::read)>> = true;
+
+// Type-erased snapshot description of one registered component type.
+struct SnapshotComponentInfo {
+    std::string name;
+    ComponentID typeID;
+    const ComponentTypeInfo* typeInfo;
+    bool sparse;
+    // Element bytes are written and read as-is, with no serializer.
+    bool raw;
+    // Serializer path for non-raw table components; readElements constructs `count` elements at `dst`.
+    void (*writeElements)(SnapshotWriter& out, const void* data, size_t count);
+    void (*readElements)(SnapshotReader& in, void* dst, size_t count);
+    // Whole sparse-set pool: entity handles followed by the component values.
+    void (*writeSparse)(const World& world, SnapshotWriter& out);
+    void (*readSparse)(World& world, SnapshotReader& in);
+    // Single values, used by deltas. assignElement overwrites an existing element; the sparse variants
+    // read or emplace the entity's value in its pool.
+    void (*assignElement)(SnapshotReader& in, void* dst);
+    void (*writeSparseValue)(const World& world, SnapshotWriter& out, EntityID entityID);
+    void (*readSparseValue)(World& world, SnapshotReader& in, EntityID entityID);
+};
+
+// A type-table entry of a snapshot or delta, resolved against this program's registry. `info` is null
+// for types that are unknown here or whose layout changed; their data is skipped.
+struct SnapshotTypeRef {
+    const SnapshotComponentInfo* info;
+    bool tag;
+};
+
+// A complete World state held in memory, and the change tick it was captured at. Everything written
+// after the capture has a newer tick, which is what World::diff relies on.
+struct WorldSnapshot {
+    std::vector<std::byte> data;
+    Tick tick = 0;
+};
+
+// The changes a World went through in the tick range (since, until]: entities that were created,
+// destroyed or gained or lost components are stored whole; for all other entities only the changed
+// component values are stored.
+struct WorldDelta {
+    std::vector<std::byte> data;
+    Tick since = 0;
+    Tick until = 0;
+};
+
+// Component types that take part in snapshots. Component type IDs depend on first-use order and so
+// differ between runs; snapshots identify types by the stable name given at registration instead.
+// Components that are not registered are left out of snapshots.
+class SnapshotRegistry {
+public:
+    // Defined in World.h, which the sparse-set thunks need.
+    template<typename T>
+    static void registerComponent(const std::string& name);
+
+    static const SnapshotComponentInfo* find(ComponentID typeID) {
+        auto& components = getComponents();
+        return typeID < components.size() && components[typeID] ? components[typeID].get() : nullptr;
+    }
+
+    static const SnapshotComponentInfo* find(const std::string& name) {
+        auto& names = getNames();
+        auto it = names.find(name);
+        return it != names.end() ? find(it->second) : nullptr;
+    }
+
+    // Shared by snapshots and deltas; see Snapshot.cpp for the layout.
+    static void writeTypeTable(SnapshotWriter& out, const std::vector<const SnapshotComponentInfo*>& types);
+    static std::vector<SnapshotTypeRef> readTypeTable(SnapshotReader& in);
+
+private:
+    static void add(std::unique_ptr<SnapshotComponentInfo> info);
+
+    static std::vector<std::unique_ptr<SnapshotComponentInfo>>& getComponents() {
+        static std::vector<std::unique_ptr<SnapshotComponentInfo>> s_components;
+        return s_components;
+    }
+
+    static std::unordered_map<std::string, ComponentID>& getNames() {
+        static std::unordered_map<std::string, ComponentID> s_names;
+        return s_names;
+    }
+};
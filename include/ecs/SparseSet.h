@@ -0,0 +1,121 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/Component.h"
+
+// Entity bookkeeping shared by every sparse-set pool: a dense entity array plus a paged sparse
+// index from entity slot index to dense position. Pages are only allocated for slot ranges that are
+// in use. Lookups compare the stored handle, so a stale generation never matches.
+class SparseSetBase {
+public:
+    static constexpr size_t PAGE_SIZE = 4096;
+    static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    virtual ~SparseSetBase() = default;
+
+    bool contains(EntityID entityID) const {
+        return indexOf(entityID) != INVALID_INDEX;
+    }
+
+    std::uint32_t indexOf(EntityID entityID) const {
+        EntityIndex entityIndex = getEntityIndex(entityID);
+        size_t page = entityIndex / PAGE_SIZE;
+        if (page >= m_sparse.size() || !m_sparse[page]) {
+            return INVALID_INDEX;
+        }
+        std::uint32_t index = m_sparse[page][entityIndex % PAGE_SIZE];
+        return index != INVALID_INDEX && m_dense[index] == entityID ? index : INVALID_INDEX;
+    }
+
+    // Swap-and-pop removal of the entity and its component. Does nothing if the entity is not present.
+    void remove(EntityID entityID);
+
+    const std::vector<EntityID>& getEntities() const { return m_dense; }
+
+    // Added/changed ticks, parallel to getEntities(), plus the newest tick of the whole pool.
+    ComponentTicks* ticks() { return m_ticks.data(); }
+    const ComponentTicks* ticks() const { return m_ticks.data(); }
+    const ComponentTicks& getPoolTicks() const { return m_poolTicks; }
+
+    void markAdded(std::uint32_t index, Tick tick) {
+        m_ticks[index] = ComponentTicks{ tick, tick };
+        m_poolTicks = ComponentTicks{ tick, tick };
+    }
+
+    void markChanged(std::uint32_t index, Tick tick) {
+        m_ticks[index].changed = tick;
+        m_poolTicks.changed = tick;
+    }
+
+    void markPoolChanged(Tick tick) { m_poolTicks.changed = tick; }
+    size_t size() const { return m_dense.size(); }
+    bool empty() const { return m_dense.empty(); }
+
+    void clear();
+
+protected:
+    std::uint32_t insertEntity(EntityID entityID);
+    void reserveEntities(size_t capacity) {
+        m_dense.reserve(capacity);
+        m_ticks.reserve(capacity);
+    }
+
+    virtual void swapAndPopData(std::uint32_t index) = 0;
+    virtual void clearData() = 0;
+
+private:
+    std::vector<std::unique_ptr<std::uint32_t[]>> m_sparse;
+    std::vector<EntityID> m_dense;
+    std::vector<ComponentTicks> m_ticks;
+    ComponentTicks m_poolTicks;
+};
+
+template<typename T>
+class SparseSet : public SparseSetBase {
+public:
+    template<typename... Args>
+    T& emplace(EntityID entityID, Tick tick, Args&&... args) {
+        std::uint32_t index = indexOf(entityID);
+        if (index != INVALID_INDEX) {
+            m_data[index] = makeComponent<T>(std::forward<Args>(args)...);
+            markChanged(index, tick);
+            return m_data[index];
+        }
+        index = insertEntity(entityID);
+        markAdded(index, tick);
+        return m_data.emplace_back(makeComponent<T>(std::forward<Args>(args)...));
+    }
+
+    T* get(EntityID entityID) {
+        std::uint32_t index = indexOf(entityID);
+        return index != INVALID_INDEX ? &m_data[index] : nullptr;
+    }
+
+    const T* get(EntityID entityID) const {
+        std::uint32_t index = indexOf(entityID);
+        return index != INVALID_INDEX ? &m_data[index] : nullptr;
+    }
+
+    void reserve(size_t capacity) {
+        reserveEntities(capacity);
+        m_data.reserve(capacity);
+    }
+
+    T* data() { return m_data.data(); }
+    const T* data() const { return m_data.data(); }
+
+protected:
+    void swapAndPopData(std::uint32_t index) override {
+        if (index + 1 != m_data.size()) {
+            m_data[index] = std::move(m_data.back());
+        }
+        m_data.pop_back();
+    }
+
+    void clearData() override {
+        m_data.clear();
+    }
+
+private:
+    std::vector<T> m_data;
+};
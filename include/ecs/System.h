@@ -2,17 +2,67 @@
 #include "pch.h"
 #include "ecs/Component.h"
 #include "ecs/Entity.h"
+#include "ecs/ComponentMask.h"
 class World;
 
+// The component types a system touches. World::update runs systems whose access sets do not conflict
+// concurrently; an exclusive system conflicts with everything and runs on the thread calling update().
+class SystemAccess {
+public:
+    static SystemAccess exclusive() {
+        SystemAccess access;
+        access.m_exclusive = true;
+        return access;
+    }
+
+    template<typename... Components>
+    SystemAccess& read() {
+        (m_reads.set<Components>(), ...);
+        return *this;
+    }
+
+    template<typename... Components>
+    SystemAccess& write() {
+        (m_writes.set<Components>(), ...);
+        return *this;
+    }
+
+    bool isExclusive() const { return m_exclusive; }
+    const ComponentMask& getReads() const { return m_reads; }
+    const ComponentMask& getWrites() const { return m_writes; }
+
+    bool canRead(ComponentID typeID) const { return m_exclusive || m_reads.test(typeID) || m_writes.test(typeID); }
+    bool canWrite(ComponentID typeID) const { return m_exclusive || m_writes.test(typeID); }
+
+    bool conflictsWith(const SystemAccess& other) const {
+        if (m_exclusive || other.m_exclusive) {
+            return true;
+        }
+        ComponentMask otherAll = other.m_reads;
+        otherAll |= other.m_writes;
+        return m_writes.intersects(otherAll) || other.m_writes.intersects(m_reads);
+    }
+
+private:
+    ComponentMask m_reads;
+    ComponentMask m_writes;
+    bool m_exclusive = false;
+};
+
+// Systems receive the World by reference. Queries returned by World::query() stay valid for the World's
+// lifetime, so a system can resolve them once in onAddedToWorld() and keep the references for update().
 class ISystem {
 public:
     virtual ~ISystem() = default;
 
-    virtual void update(float deltaTime, std::shared_ptr<World> world) = 0;
+    virtual void update(float deltaTime, World& world) = 0;
+
+    virtual void onAddedToWorld(World& world) {}
 
-    virtual void onAddedToWorld(std::shared_ptr<World> world) {}
+    virtual void onRemovedFromWorld(World& world) {}
 
-    virtual void onRemovedFromWorld(std::shared_ptr<World> world) {}
+    // Systems that do not override this run exclusively, in insertion order relative to every other system.
+    virtual SystemAccess getAccess() const { return SystemAccess::exclusive(); }
 
     virtual bool isEnabled() const { return m_enabled; }
     virtual void setEnabled(bool enabled) { m_enabled = enabled; }
@@ -20,7 +70,16 @@ public:
     virtual std::string getName() const { return m_name; }
     virtual void setName(const std::string& name) { m_name = name; }
 
+    // World tick at which this system last started running, or 0 before its first run. Pass it to the
+    // Added / Changed query filters to visit only what changed since then.
+    Tick getLastRunTick() const { return m_lastRunTick; }
+
 protected:
     bool m_enabled = true;
     std::string m_name;
+
+private:
+    Tick m_lastRunTick = 0;
+
+    friend class World;
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include "pch.h"
+#include "ecs/Entity.h"
+#include "ecs/System.h"
+#include "ecs/Query.h"
+#include "ecs/Hierarchy.h"
+
+// Computes WorldTransform for every entity that has both a LocalTransform and a WorldTransform.
+//
+// The hierarchy is flattened into one array per root: each root's subtree is stored contiguously in
+// breadth-first order, so every parent precedes its children and one linear pass over the array
+// resolves the whole subtree. The layout is rebuilt only when the hierarchy changes: a Changed<Parent>
+// or Changed<Children>, an added transform, or a laid out entity that was destroyed or lost its
+// transforms (checked only when World::getRemovalTick has moved). The entities involved mark their
+// roots in the new layout dirty, and those subtrees are recomputed in full; the others keep their
+// matrices. Between rebuilds only the subtrees containing a changed LocalTransform are walked, and
+// within them entities whose LocalTransform and ancestors are unchanged are skipped. Independent roots
+// are propagated in parallel.
+class TransformSystem : public ISystem {
+public:
+    TransformSystem() { m_name = "TransformSystem"; }
+
+    void onAddedToWorld(World& world) override;
+    void update(float deltaTime, World& world) override;
+
+    SystemAccess getAccess() const override {
+        return SystemAccess().read<LocalTransform, Parent, Children>().write<WorldTransform>();
+    }
+
+    // Below this many hierarchy entries the propagation stays on the calling thread.
+    static constexpr size_t PARALLEL_THRESHOLD = 4096;
+    // Approximate number of entries handed to one job.
+    static constexpr size_t PARALLEL_CHUNK_ENTRIES = 1024;
+
+    static constexpr std::uint32_t INVALID_ENTRY = std::numeric_limits<std::uint32_t>::max();
+
+private:
+    struct Entry {
+        EntityID entity;
+        // Index of the parent's entry in m_entries, or -1 for a root.
+        std::int32_t parent;
+        std::uint32_t root;
+    };
+
+    // Fills m_movedEntities with the entities whose place in the hierarchy changed since `since`, looked
+    // up in the current layout. Returns true if the layout has to be rebuilt.
+    bool collectMovedEntities(const World& world, Tick since);
+    // Fills m_dirtyRoots with the roots whose subtree holds a LocalTransform changed since `since` or,
+    // after a rebuild, one of m_movedEntities.
+    void collectDirtyRoots(Tick since, bool rebuilt);
+    void queueRoot(EntityID entityID);
+    void rebuild(const World& world);
+    static bool hasTransforms(const World& world, EntityID entityID);
+    void propagate(const World& world, std::uint32_t root, Tick since, bool force);
+
+    Query<const LocalTransform, const WorldTransform>* m_transforms = nullptr;
+    Query<const Parent>* m_parents = nullptr;
+    Query<const Children>* m_children = nullptr;
+
+    std::vector<Entry> m_entries;
+    // Start of each root's subtree in m_entries, followed by m_entries.size().
+    std::vector<std::uint32_t> m_rootOffsets;
+    // Entry of every laid out entity, indexed by entity slot; INVALID_ENTRY if not in the hierarchy.
+    std::vector<std::uint32_t> m_entityEntries;
+    std::vector<EntityID> m_movedEntities;
+    // Per entry: the entity was destroyed or lost its transforms. Only filled after removals.
+    std::vector<std::uint8_t> m_lost;
+    // The previous layout while rebuild() carries matrices over to the new one.
+    std::vector<Entry> m_previousEntries;
+    std::vector<glm::mat4> m_previousMatrices;
+    // Roots to propagate this run, and a per-root flag so each is listed once.
+    std::vector<std::uint32_t> m_dirtyRoots;
+    std::vector<std::uint8_t> m_rootQueued;
+    std::vector<glm::mat4> m_worldMatrices;
+    std::vector<std::uint8_t> m_dirty;
+
+    // Set when propagation meets an entity that lost its transform or was destroyed behind our back.
+    std::atomic<bool> m_stale{ false };
+};
@@ -4,18 +4,52 @@
 #include "ecs/Component.h"
 #include "ecs/System.h"
 #include "ecs/ComponentMask.h"
+#include "ecs/Archetype.h"
+#include "ecs/SparseSet.h"
+#include "ecs/Query.h"
+#include "ecs/Resource.h"
+#include "ecs/Snapshot.h"
+
+class CommandBuffer;
 
 class World : public std::enable_shared_from_this<World> {
 public:
-    World() = default;
-    ~World() = default;
+    World();
+    ~World();
 
 
     EntityID createEntity();
     void destroyEntity(EntityID entityID);
     bool isValidEntity(EntityID entityID) const;
 
-
+    // Creates `count` entities that each start with a copy of `prototypes`. The target archetype is
+    // resolved and reserved once and each column is filled in a single pass.
+    template<typename... Components>
+    std::vector<EntityID> createEntities(size_t count, const Components&... prototypes);
+
+    // Destroys every valid entity in `entityIDs` and returns their slots to the free list in one batch.
+    // Invalid and duplicate handles are skipped.
+    void destroyEntities(const std::vector<EntityID>& entityIDs);
+
+    // Thread-safe handle reservation for spawning from worker threads. Reserved handles become live,
+    // component-less entities at the next flushReservedEntities(), which createEntity, destroyEntity,
+    // addComponent and update() call implicitly.
+    //
+    // All threads share one atomic cursor rather than caching blocks of indices per worker: flushing
+    // materializes every index the cursor has passed, so indices parked in a worker's cache would turn
+    // into entities nobody asked for. Each call is a single fetch_sub with no retry loop, so it never
+    // blocks, but concurrent callers serialize on the cursor's cache line. That costs little for a few
+    // spawns per job and becomes the bottleneck when many workers reserve one handle at a time in a
+    // tight loop. Reserving a whole batch costs the same single atomic operation, so workers that spawn
+    // in bulk should reserve everything they need up front into a thread-local buffer.
+    EntityID reserveEntity();
+    void reserveEntities(size_t count, std::vector<EntityID>& out);
+    void flushReservedEntities();
+
+    // Adds T, or overwrites the entity's existing T. The value is built from `args` before the entity
+    // moves to its new archetype, so arguments may refer to the entity's own components. The returned
+    // reference, like the pointers from getComponent, points into storage that the next structural
+    // change (adding, removing, creating, destroying, loading) may relocate; do not keep it past one.
     template<typename T, typename... Args>
     T& addComponent(EntityID entityID, Args&&... args);
 
@@ -31,6 +65,27 @@ public:
     template<typename T>
     bool hasComponent(EntityID entityID) const;
 
+    // Added / changed ticks of the entity's T, or nullptr if it has none. Reading them does not stamp anything.
+    template<typename T>
+    const ComponentTicks* getComponentTicks(EntityID entityID) const;
+
+
+    // Resources are per-World singletons addressed by type, for frame-global state that does not belong
+    // to any entity. Access is a vector index by a dense per-type ID. setResource replaces an existing value.
+    template<typename T, typename... Args>
+    T& setResource(Args&&... args);
+
+    template<typename T>
+    T* getResource();
+
+    template<typename T>
+    const T* getResource() const;
+
+    template<typename T>
+    bool hasResource() const { return getResource<T>() != nullptr; }
+
+    template<typename T>
+    void removeResource();
 
     template<typename T, typename... Args>
     std::shared_ptr<T> addSystem(Args&&... args);
@@ -41,6 +96,12 @@ public:
     template<typename T>
     void removeSystem();
 
+    template<typename... Components>
+    Query<Components...>& query();
+
+    template<typename... Components>
+    const Query<Components...>& query() const;
+
     template<typename... Components>
     std::vector<EntityID> getEntitiesWith() const;    template<typename... Components, typename Func>
         void forEach(Func&& func);
@@ -48,7 +109,75 @@ public:
     template<typename... Components, typename Func>
     void forEach(Func&& func) const;
 
-    const std::unordered_set<EntityID>& getAllEntities() const { return m_entities; }
+    // Runs `func` over the matching entities on the World's JobSystem. See Query::parallelForEach.
+    template<typename... Components, typename Func>
+    void parallelForEach(Func&& func);
+
+    // JobSystem::parallelFor for work on this World. Each chunk runs in the context of the calling
+    // system on whichever thread executes it, so access checks and change ticks follow the caller and
+    // not a system the executing thread happens to be waiting in. Writes from a chunk stamp only their
+    // rows; the column and pool ticks they need are raised on the calling thread once all chunks are done.
+    // With `deterministic`, each chunk records commands into its own stream; see setDeterministic().
+    void parallelFor(JobSystem& jobs, size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func, bool deterministic);
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func) {
+        parallelFor(getJobSystem(), count, grainSize, func, m_deterministic);
+    }
+
+    // Shared buffer for structural changes requested while iterating. Systems may record into it from
+    // any thread; update() plays it back once all systems have finished.
+    CommandBuffer& getCommandBuffer();
+
+    // Non-const access (getComponent on a non-const World, or iterating a non-const component type)
+    // stamps the component as changed with this tick. See Added / Changed in Query.h.
+    // Inside a system this is the tick the system started at.
+    Tick getChangeTick() const {
+        return t_currentSystem ? t_currentSystem->tick : m_changeTick.load(std::memory_order_relaxed);
+    }
+
+    JobSystem& getJobSystem();
+    // Must not be called while update() runs.
+    void setJobSystem(std::shared_ptr<JobSystem> jobSystem);
+
+    // In deterministic mode the structural results of parallel work do not depend on thread timing:
+    // chunk bounds are fixed by the row count alone, and commands recorded from each chunk of a
+    // parallelFor / parallelForEach are played back in chunk order. Chunks still run on any thread in
+    // any order, so `func` must not depend on that itself, e.g. through unordered floating-point sums.
+    void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+    bool isDeterministic() const { return m_deterministic; }
+
+    std::vector<EntityID> getAllEntities() const;
+    size_t getEntityCount() const { return m_entityCount; }
+    // Change tick of the last entity destruction or component removal. Removals leave no Changed tick
+    // behind, so systems that cache entity relations check this to know when one may have gone stale.
+    Tick getRemovalTick() const { return m_removalTick; }
+
+    // Binary snapshots of every entity and its components registered with SnapshotRegistry. Table
+    // columns of trivially copyable types are written and restored as single raw blocks. Loading
+    // replaces all entities of this World and restores them under their saved handles, together with
+    // the order of the free list, so the loaded World hands out the same handles the saved one would
+    // have. Systems and resources are untouched. Loaded components count as added at the current change
+    // tick.
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
+    bool saveSnapshot(const std::filesystem::path& path) const;
+    bool loadSnapshot(const std::filesystem::path& path);
+
+    // In-memory snapshots and deltas for rollback and replay. Capturing and diffing advance the change
+    // tick, so later writes land in the next delta. Inside a system, whose writes all carry the tick it
+    // started at, the captured state is dated just before that system instead; the next delta then
+    // repeats what the system wrote before capturing. Both are structural operations and are refused in
+    // non-exclusive systems. diff() finds changed values through the column and row ticks and structural
+    // changes through a per-entity tick, so its output and most of its cost scale with what changed
+    // since `since`; only a scan of the entity slot table is linear in the World's size. Applying a
+    // delta to a World in the `since` state yields the `until` state.
+    WorldSnapshot captureSnapshot();
+    bool restoreSnapshot(const WorldSnapshot& snapshot);
+    WorldDelta diff(Tick since);
+    WorldDelta diff(const WorldSnapshot& base) { return diff(base.tick); }
+    // Delta between two captured states, found by loading both and comparing every entity and value, so
+    // it costs a full load of each. Works for snapshots from any World with the same registered types.
+    static WorldDelta diff(const WorldSnapshot& from, const WorldSnapshot& to);
+    bool applyDelta(const WorldDelta& delta);
 
     void update(float deltaTime);
 
@@ -56,119 +185,527 @@ public:
     void shutdown();
 
 private:
-    std::unordered_set<EntityID> m_entities;
+    // One slot per entity index. A slot is alive while `archetype` is set; `generation` is bumped on
+    // destruction so old handles stop matching. Sparse-set membership lives in `sparseMask`.
+    struct EntityRecord {
+        Archetype* archetype = nullptr;
+        std::uint32_t row = 0;
+        EntityGeneration generation = 0;
+        // Tick of the last create, destroy or component add / remove; lets diff() find structural changes.
+        Tick structureTick = 0;
+        ComponentMask sparseMask;
+    };
+
+    std::vector<EntityRecord> m_entityRecords;
+    std::vector<EntityIndex> m_freeIndices;
+    size_t m_entityCount = 0;
+
+    // Reservations pop m_freeIndices from the back by decrementing this cursor; once it goes negative,
+    // -cursor new slots past the end of m_entityRecords have been reserved. Equal to m_freeIndices.size()
+    // when nothing is pending. Kept on its own cache line: reserving workers write it while every
+    // component lookup reads the m_entityRecords next to it.
+    alignas(64) std::atomic<std::int64_t> m_freeCursor{ 0 };
+    char m_freeCursorPadding[64 - sizeof(std::atomic<std::int64_t>)] = {};
+
+    EntityID reservedEntityAt(std::int64_t cursor) const;
+
+    // Takes `count` slots (recycled first, then new ones) and appends their handles to `out` without
+    // attaching them to an archetype.
+    void allocateIndices(size_t count, std::vector<EntityID>& out);
+    void releaseEntity(EntityRecord& record, EntityID entityID);
+    // Destroys every entity but keeps the slots, bumping their generations so old handles stay invalid.
+    void clearEntities();
+    // Installs a saved free list (bottom of the stack first) and recomputes the entity count. Free slots
+    // it does not name go beneath it. Returns false, falling back to index order, if it names a live,
+    // out-of-range or repeated slot.
+    bool restoreFreeIndices(const std::vector<EntityIndex>& freeIndices);
+    // Change tick that dates a captured snapshot or delta; see captureSnapshot().
+    Tick advanceCaptureTick();
+    bool hasReservedEntities() const {
+        return m_freeCursor.load(std::memory_order_relaxed) != static_cast<std::int64_t>(m_freeIndices.size());
+    }
+
+    EntityRecord* findRecord(EntityID entityID) {
+        EntityIndex index = getEntityIndex(entityID);
+        if (index >= m_entityRecords.size()) {
+            return nullptr;
+        }
+        EntityRecord& record = m_entityRecords[index];
+        return record.generation == getEntityGeneration(entityID) && record.archetype ? &record : nullptr;
+    }
+
+    const EntityRecord* findRecord(EntityID entityID) const {
+        return const_cast<World*>(this)->findRecord(entityID);
+    }
+
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> m_archetypes;
+    std::vector<Archetype*> m_archetypeList;
+    Archetype* m_emptyArchetype = nullptr;
+
+    Archetype* findArchetype(const ComponentMask& mask) const;
+    Archetype* registerArchetype(std::unique_ptr<Archetype> archetype);
+    void moveEntity(EntityRecord& record, Archetype& dst);
+
+    Archetype* getAddTransition(Archetype& src, ComponentID typeID, const ComponentTypeInfo& info);
+    Archetype* getRemoveTransition(Archetype& src, ComponentID typeID);
+
+    // Archetypes are keyed by their table components only; sparse-set components are tracked per entity
+    // in EntityRecord::sparseMask.
+    template<typename... Components>
+    static ComponentMask makeTableMask();
 
-    std::unordered_map<EntityID, std::unordered_map<ComponentID, std::unique_ptr<IComponent>>> m_components;
+    std::vector<std::unique_ptr<SparseSetBase>> m_sparseSets;
 
-    std::unordered_map<EntityID, ComponentMask> m_entityMasks;
+    template<typename T>
+    SparseSet<std::remove_const_t<T>>* getSparseSet(ComponentID typeID) const;
+
+    template<typename T>
+    SparseSet<T>& assureSparseSet(ComponentID typeID);
+
+    template<typename... Components>
+    const SparseSetBase* findSmallestSparseSet() const;
+
+    template<typename Filter>
+    bool matchesFilter(const Filter& filter, EntityID entityID) const;
+
+    // getComponent for parallel iteration: stamps only the entity's own change tick, never the shared
+    // pool or column tick, which the caller must raise once before dispatching workers.
+    template<typename T>
+    T* getComponentForWorker(EntityID entityID, Tick tick);
+
+    // Sparse-set pools are saved per entity (handle, then value); used through SnapshotComponentInfo.
+    template<typename T>
+    void writeSparseSnapshot(SnapshotWriter& out) const;
+
+    template<typename T>
+    void readSparseSnapshot(SnapshotReader& in);
+
+    // Writes one component value of an entity as a u32 byte size followed by the value.
+    void writeDeltaValue(SnapshotWriter& out, const SnapshotComponentInfo& info, const EntityRecord& record, EntityID entityID) const;
+    bool applyStructuralDelta(SnapshotReader& in, const std::vector<SnapshotTypeRef>& types, Tick tick);
+
+    friend class SnapshotRegistry;
+    friend class CommandBuffer;
+
+    // Queries are created on first use and cached for the World's lifetime, hence mutable. Concurrently
+    // scheduled systems may create them at the same time, so the cache is guarded by m_queryMutex.
+    mutable std::vector<std::unique_ptr<QueryBase>> m_queries;
+    mutable std::mutex m_queryMutex;
+
+    template<typename... Components>
+    Query<Components...>& assureQuery() const;
+
+    std::shared_ptr<JobSystem> m_jobSystem;
+    bool m_deterministic = false;
+
+    std::unique_ptr<CommandBuffer> m_commandBuffer;
+
+    std::vector<std::shared_ptr<void>> m_resources;
+
+    // Starts above zero so everything created before a system's first run counts as added for it.
+    std::atomic<Tick> m_changeTick{ 1 };
+    Tick m_removalTick = 0;
 
     std::vector<std::shared_ptr<ISystem>> m_systems;
-    std::unordered_map<std::type_index, std::shared_ptr<ISystem>> m_systemMap;    template<typename T>
-        static ComponentID getComponentTypeID();
+    std::unordered_map<std::type_index, std::shared_ptr<ISystem>> m_systemMap;
+
+    // Dependency graph over m_systems, rebuilt whenever a system is added or removed.
+    // An edge i -> j exists when system j comes after system i and their access sets conflict.
+    struct SystemNode {
+        SystemAccess access;
+        std::vector<size_t> dependents;
+        size_t dependencyCount = 0;
+        Tick tick = 0;
+    };
+    std::vector<SystemNode> m_schedule;
+    bool m_scheduleDirty = true;
+    bool m_hasConcurrentSystems = false;
+
+    void buildSchedule();
+    void runSystem(size_t index, float deltaTime);
+    void runSystemsConcurrently(float deltaTime);
+
+    // The system currently executing on this thread, used to validate component access in debug builds.
+    static inline thread_local const SystemNode* t_currentSystem = nullptr;
+
+    // Columns and pools written by the parallel chunk running on this thread, whose shared ticks the
+    // dispatching thread raises after the join. Null outside chunks.
+    struct ChunkStamps {
+        std::vector<ComponentColumn*> columns;
+        std::vector<SparseSetBase*> pools;
+    };
+    static inline thread_local ChunkStamps* t_chunkStamps = nullptr;
+
+    // Stamp a row or a whole column / pool as changed, deferring the shared tick inside a parallel chunk.
+    void stampChanged(ComponentColumn& column, size_t row, Tick tick);
+    void stampChanged(SparseSetBase& pool, std::uint32_t index, Tick tick);
+    void stampColumnChanged(ComponentColumn& column, Tick tick);
+    void stampPoolChanged(SparseSetBase& pool, Tick tick);
 
-    static inline std::unordered_map<std::type_index, ComponentID> s_componentTypeIDs;
-    static inline std::mutex s_componentTypeMutex;
+    template<typename T>
+    void checkAccess(bool write) const;
+    void checkStructuralChange(const char* operation) const;
+    template<typename T>
+        static ComponentID getComponentTypeID() { return ComponentType<T>::id(); }
 
     friend class ComponentMask;
+
+    template<typename... Components>
+    friend class Query;
 };
 
+template<typename... Components>
+ComponentMask World::makeTableMask() {
+    ComponentMask mask;
+    ((isSparseComponent<Components> ? void() : mask.set<Components>()), ...);
+    return mask;
+}
+
 template<typename T>
-ComponentID World::getComponentTypeID() {
-    std::lock_guard<std::mutex> lock(s_componentTypeMutex);
-    std::type_index typeIndex = std::type_index(typeid(T));
+SparseSet<std::remove_const_t<T>>* World::getSparseSet(ComponentID typeID) const {
+    if (typeID >= m_sparseSets.size()) {
+        return nullptr;
+    }
+    return static_cast<SparseSet<std::remove_const_t<T>>*>(m_sparseSets[typeID].get());
+}
 
-    auto it = s_componentTypeIDs.find(typeIndex);
-    if (it != s_componentTypeIDs.end()) {
-        return it->second;
+template<typename T>
+void World::checkAccess(bool write [[maybe_unused]]) const {
+#ifndef NDEBUG
+    if (!t_currentSystem) {
+        return;
+    }
+    ComponentID typeID = ComponentType<T>::id();
+    const SystemAccess& access = t_currentSystem->access;
+    if (write ? !access.canWrite(typeID) : !access.canRead(typeID)) {
+        LOG_ERROR("World: A system {} component '{}' without declaring it in getAccess().",
+            write ? "writes" : "reads", getComponentTypeInfo<std::remove_const_t<T>>().name);
+        assert(false && "Undeclared component access from a concurrently scheduled system");
     }
+#endif
+}
 
-    ComponentID newID = ComponentTypeIDAllocator::allocate();
-    s_componentTypeIDs[typeIndex] = newID;
-    return newID;
+template<typename T>
+SparseSet<T>& World::assureSparseSet(ComponentID typeID) {
+    if (typeID >= m_sparseSets.size()) {
+        m_sparseSets.resize(typeID + 1);
+    }
+    if (!m_sparseSets[typeID]) {
+        m_sparseSets[typeID] = std::make_unique<SparseSet<T>>();
+    }
+    return static_cast<SparseSet<T>&>(*m_sparseSets[typeID]);
+}
+
+template<typename... Components>
+const SparseSetBase* World::findSmallestSparseSet() const {
+    const SparseSetBase* smallest = nullptr;
+    bool missing = false;
+    auto consider = [&](const SparseSetBase* pool) {
+        if (!pool) {
+            missing = true;
+        }
+        else if (!smallest || pool->size() < smallest->size()) {
+            smallest = pool;
+        }
+    };
+    ((isSparseComponent<Components> ? consider(getSparseSet<Components>(getComponentTypeID<Components>())) : void()), ...);
+    return missing ? nullptr : smallest;
+}
+
+template<typename T>
+const ComponentTicks* World::getComponentTicks(EntityID entityID) const {
+    ComponentID typeID = getComponentTypeID<T>();
+
+    if constexpr (isSparseComponent<T>) {
+        const auto* pool = getSparseSet<T>(typeID);
+        std::uint32_t index = pool ? pool->indexOf(entityID) : SparseSetBase::INVALID_INDEX;
+        return index != SparseSetBase::INVALID_INDEX ? pool->ticks() + index : nullptr;
+    }
+
+    const EntityRecord* record = findRecord(entityID);
+    const ComponentColumn* column = record ? record->archetype->getColumn(typeID) : nullptr;
+    return column ? column->ticks() + record->row : nullptr;
+}
+
+template<typename Filter>
+bool World::matchesFilter(const Filter& filter, EntityID entityID) const {
+    if constexpr (std::is_same_v<Filter, NoFilter>) {
+        return true;
+    }
+    else {
+        const ComponentTicks* ticks = getComponentTicks<typename Filter::Component>(entityID);
+        return ticks && filter.matches(*ticks);
+    }
 }
 
 template<typename T, typename... Args>
 T& World::addComponent(EntityID entityID, Args&&... args) {
-    static_assert(std::is_base_of_v<IComponent, T>, "T must inherit from IComponent");
+    checkStructuralChange("addComponent");
+    flushReservedEntities();
+
+    EntityRecord* found = findRecord(entityID);
+    if (!found) {
+        LOG_ERROR("World::addComponent: Entity {} does not exist.", entityID);
+        throw std::invalid_argument("World::addComponent: invalid entity");
+    }
 
     ComponentID typeID = getComponentTypeID<T>();
-    auto component = std::make_unique<T>(std::forward<Args>(args)...);
-    T& ref = *component;
 
-    m_components[entityID][typeID] = std::move(component);
+    if constexpr (isSparseComponent<T>) {
+        if (!found->sparseMask.test(typeID)) {
+            found->sparseMask.set(typeID);
+            found->structureTick = getChangeTick();
+        }
+        return assureSparseSet<T>(typeID).emplace(entityID, getChangeTick(), std::forward<Args>(args)...);
+    }
+
+    EntityRecord& record = *found;
 
+    if constexpr (isTagComponent<T>) {
+        if (!record.archetype->getMask().test(typeID)) {
+            moveEntity(record, *getAddTransition(*record.archetype, typeID, getComponentTypeInfo<T>()));
+        }
+        return getTagInstance<T>();
+    }
+
+    if (ComponentColumn* column = record.archetype->getColumn(typeID)) {
+        T& existing = column->data<T>()[record.row];
+        existing = makeComponent<T>(std::forward<Args>(args)...);
+        column->markChanged(record.row, getChangeTick());
+        return existing;
+    }
 
-    m_entityMasks[entityID].set<T>();
+    // Arguments may point into columns that the move or the append below relocates.
+    T value = makeComponent<T>(std::forward<Args>(args)...);
+    Archetype* dst = getAddTransition(*record.archetype, typeID, getComponentTypeInfo<T>());
+    moveEntity(record, *dst);
 
-    return ref;
+    ComponentColumn* column = dst->getColumn(typeID);
+    T& component = column->emplace<T>(std::move(value));
+    column->markAdded(record.row, getChangeTick());
+    return component;
+}
+
+template<typename... Components>
+std::vector<EntityID> World::createEntities(size_t count, const Components&... prototypes) {
+    checkStructuralChange("createEntities");
+    flushReservedEntities();
+
+    std::vector<EntityID> entityIDs;
+    if (count == 0) {
+        return entityIDs;
+    }
+    allocateIndices(count, entityIDs);
+
+    Archetype* archetype = m_emptyArchetype;
+    ((archetype = isSparseComponent<Components>
+        ? archetype
+        : getAddTransition(*archetype, getComponentTypeID<Components>(), getComponentTypeInfo<Components>())), ...);
+
+    ComponentMask sparseMask;
+    ((isSparseComponent<Components> ? sparseMask.set<Components>() : void()), ...);
+
+    const Tick tick = getChangeTick();
+    archetype->reserve(archetype->size() + count);
+    for (EntityID entityID : entityIDs) {
+        EntityRecord& record = m_entityRecords[getEntityIndex(entityID)];
+        record.archetype = archetype;
+        record.row = static_cast<std::uint32_t>(archetype->pushEntity(entityID));
+        record.structureTick = tick;
+        record.sparseMask = sparseMask;
+    }
+
+    [[maybe_unused]] auto fill = [&](const auto& prototype) {
+        using T = std::decay_t<decltype(prototype)>;
+        ComponentID typeID = getComponentTypeID<T>();
+        if constexpr (isSparseComponent<T>) {
+            SparseSet<T>& pool = assureSparseSet<T>(typeID);
+            pool.reserve(pool.size() + count);
+            for (EntityID entityID : entityIDs) {
+                pool.emplace(entityID, tick, prototype);
+            }
+        }
+        else if constexpr (!isTagComponent<T>) {
+            ComponentColumn* column = archetype->getColumn(typeID);
+            for (size_t i = 0; i < count; i++) {
+                column->emplace<T>(prototype);
+                column->markAdded(column->size() - 1, tick);
+            }
+        }
+    };
+    (fill(prototypes), ...);
+
+    return entityIDs;
 }
 
 template<typename T>
 T* World::getComponent(EntityID entityID) {
+    constexpr bool write = !std::is_const_v<T>;
+    checkAccess<T>(write);
     ComponentID typeID = getComponentTypeID<T>();
 
-    auto entityIt = m_components.find(entityID);
-    if (entityIt == m_components.end()) {
+    if constexpr (isSparseComponent<T>) {
+        auto* pool = getSparseSet<T>(typeID);
+        std::uint32_t index = pool ? pool->indexOf(entityID) : SparseSetBase::INVALID_INDEX;
+        if (index == SparseSetBase::INVALID_INDEX) {
+            return nullptr;
+        }
+        if constexpr (write) {
+            stampChanged(*pool, index, getChangeTick());
+        }
+        return pool->data() + index;
+    }
+
+    const EntityRecord* record = findRecord(entityID);
+    if (!record) {
         return nullptr;
     }
 
-    auto componentIt = entityIt->second.find(typeID);
-    if (componentIt == entityIt->second.end()) {
+    if constexpr (isTagComponent<T>) {
+        return record->archetype->getMask().test(typeID) ? &getTagInstance<T>() : nullptr;
+    }
+
+    ComponentColumn* column = record->archetype->getColumn(typeID);
+    if (!column) {
         return nullptr;
     }
+    if constexpr (write) {
+        stampChanged(*column, record->row, getChangeTick());
+    }
+    return column->data<T>() + record->row;
+}
+
+template<typename T>
+T* World::getComponentForWorker(EntityID entityID, Tick tick [[maybe_unused]]) {
+    constexpr bool write = !std::is_const_v<T>;
+    ComponentID typeID = getComponentTypeID<T>();
+
+    if constexpr (isSparseComponent<T>) {
+        auto* pool = getSparseSet<T>(typeID);
+        std::uint32_t index = pool ? pool->indexOf(entityID) : SparseSetBase::INVALID_INDEX;
+        if (index == SparseSetBase::INVALID_INDEX) {
+            return nullptr;
+        }
+        if constexpr (write) {
+            pool->ticks()[index].changed = tick;
+        }
+        return pool->data() + index;
+    }
 
-    return static_cast<T*>(componentIt->second.get());
+    const EntityRecord* record = findRecord(entityID);
+    if (!record) {
+        return nullptr;
+    }
+
+    if constexpr (isTagComponent<T>) {
+        return record->archetype->getMask().test(typeID) ? &getTagInstance<T>() : nullptr;
+    }
+
+    ComponentColumn* column = record->archetype->getColumn(typeID);
+    if (!column) {
+        return nullptr;
+    }
+    if constexpr (write) {
+        column->ticks()[record->row].changed = tick;
+    }
+    return column->data<T>() + record->row;
 }
 
 template<typename T>
 const T* World::getComponent(EntityID entityID) const {
+    checkAccess<T>(false);
     ComponentID typeID = getComponentTypeID<T>();
 
-    auto entityIt = m_components.find(entityID);
-    if (entityIt == m_components.end()) {
-        return nullptr;
+    if constexpr (isSparseComponent<T>) {
+        const auto* pool = getSparseSet<T>(typeID);
+        return pool ? pool->get(entityID) : nullptr;
     }
 
-    auto componentIt = entityIt->second.find(typeID);
-    if (componentIt == entityIt->second.end()) {
+    const EntityRecord* record = findRecord(entityID);
+    if (!record) {
         return nullptr;
     }
 
-    return static_cast<const T*>(componentIt->second.get());
+    if constexpr (isTagComponent<T>) {
+        return record->archetype->getMask().test(typeID) ? &getTagInstance<T>() : nullptr;
+    }
+
+    const ComponentColumn* column = record->archetype->getColumn(typeID);
+    return column ? column->data<T>() + record->row : nullptr;
 }
 
 template<typename T>
 void World::removeComponent(EntityID entityID) {
-    ComponentID typeID = getComponentTypeID<T>();
+    checkStructuralChange("removeComponent");
 
-    auto entityIt = m_components.find(entityID);
-    if (entityIt != m_components.end()) {
-        entityIt->second.erase(typeID);
-        if (entityIt->second.empty()) {
-            m_components.erase(entityIt);
-        }
+    EntityRecord* record = findRecord(entityID);
+    if (!record) {
+        return;
     }
 
+    ComponentID typeID = getComponentTypeID<T>();
 
-    auto maskIt = m_entityMasks.find(entityID);
-    if (maskIt != m_entityMasks.end()) {
-        maskIt->second.unset<T>();
-        if (maskIt->second.empty()) {
-            m_entityMasks.erase(maskIt);
+    if constexpr (isSparseComponent<T>) {
+        auto* pool = getSparseSet<T>(typeID);
+        if (!pool || !pool->contains(entityID)) {
+            return;
+        }
+        pool->remove(entityID);
+        record->sparseMask.unset<T>();
+        record->structureTick = getChangeTick();
+    }
+    else {
+        if (!record->archetype->getMask().test(typeID)) {
+            return;
         }
+        moveEntity(*record, *getRemoveTransition(*record->archetype, typeID));
     }
+    m_removalTick = getChangeTick();
 }
 
 template<typename T>
 bool World::hasComponent(EntityID entityID) const {
     ComponentID typeID = getComponentTypeID<T>();
 
-    auto entityIt = m_components.find(entityID);
-    if (entityIt == m_components.end()) {
-        return false;
+    if constexpr (isSparseComponent<T>) {
+        const auto* pool = getSparseSet<T>(typeID);
+        return pool && pool->contains(entityID);
     }
 
-    return entityIt->second.find(typeID) != entityIt->second.end();
+    const EntityRecord* record = findRecord(entityID);
+    return record && record->archetype->getMask().test(typeID);
+}
+
+template<typename T, typename... Args>
+T& World::setResource(Args&&... args) {
+    size_t id = ResourceType<T>::id();
+    if (id >= m_resources.size()) {
+        m_resources.resize(id + 1);
+    }
+    auto resource = std::make_shared<T>(makeComponent<T>(std::forward<Args>(args)...));
+    T& value = *resource;
+    m_resources[id] = std::move(resource);
+    return value;
+}
+
+template<typename T>
+T* World::getResource() {
+    size_t id = ResourceType<T>::id();
+    return id < m_resources.size() ? static_cast<T*>(m_resources[id].get()) : nullptr;
+}
+
+template<typename T>
+const T* World::getResource() const {
+    size_t id = ResourceType<T>::id();
+    return id < m_resources.size() ? static_cast<const T*>(m_resources[id].get()) : nullptr;
+}
+
+template<typename T>
+void World::removeResource() {
+    size_t id = ResourceType<T>::id();
+    if (id < m_resources.size()) {
+        m_resources[id].reset();
+    }
 }
 
 template<typename T, typename... Args>
@@ -178,8 +715,9 @@ std::shared_ptr<T> World::addSystem(Args&&... args) {
     auto system = std::make_shared<T>(std::forward<Args>(args)...);
     m_systems.push_back(system);
     m_systemMap[std::type_index(typeid(T))] = system;
+    m_scheduleDirty = true;
 
-    system->onAddedToWorld(shared_from_this());
+    system->onAddedToWorld(*this);
     return system;
 }
 
@@ -199,72 +737,526 @@ void World::removeSystem() {
 
     if (it != m_systemMap.end()) {
         auto system = it->second;
-        system->onRemovedFromWorld(shared_from_this());
+        system->onRemovedFromWorld(*this);
 
         m_systems.erase(std::remove(m_systems.begin(), m_systems.end(), system), m_systems.end());
         m_systemMap.erase(it);
+        m_scheduleDirty = true;
     }
 }
 
 
+template<typename... Components>
+Query<Components...>& World::assureQuery() const {
+    size_t id = QueryType<Components...>::id();
+    std::lock_guard<std::mutex> lock(m_queryMutex);
+    if (id >= m_queries.size()) {
+        m_queries.resize(id + 1);
+    }
+    if (!m_queries[id]) {
+        m_queries[id] = std::make_unique<Query<Components...>>(const_cast<World&>(*this));
+    }
+    return static_cast<Query<Components...>&>(*m_queries[id]);
+}
+
+template<typename... Components>
+Query<Components...>& World::query() {
+    return assureQuery<Components...>();
+}
+
+template<typename... Components>
+const Query<Components...>& World::query() const {
+    return assureQuery<Components...>();
+}
+
 template<typename... Components>
 std::vector<EntityID> World::getEntitiesWith() const {
-    std::vector<EntityID> result;
+    return query<Components...>().getEntities();
+}
+
+template<typename... Components, typename Func>
+void World::forEach(Func&& func) {
+    query<Components...>().forEach(std::forward<Func>(func));
+}
+
+template<typename... Components, typename Func>
+void World::forEach(Func&& func) const {
+    query<Components...>().forEach(std::forward<Func>(func));
+}
+
+template<typename... Components, typename Func>
+void World::parallelForEach(Func&& func) {
+    query<Components...>().parallelForEach(getJobSystem(), std::forward<Func>(func), m_deterministic);
+}
+
 
-    for (const auto& entityID : m_entities) {
-        if ((hasComponent<Components>(entityID) && ...)) {
-            result.push_back(entityID);
+template<typename... Components>
+Query<Components...>::Query(World& world)
+    : QueryBase(World::makeTableMask<Components...>()), m_world(&world), m_typeIDs{ ComponentType<Components>::id()... } {
+    for (Archetype* archetype : world.m_archetypeList) {
+        onArchetypeCreated(archetype);
+    }
+}
+
+template<typename... Components>
+template<typename Func>
+void Query<Components...>::forEach(Func&& func) {
+    each(NoFilter{}, std::forward<Func>(func));
+}
+
+template<typename... Components>
+template<typename Func>
+void Query<Components...>::forEach(Func&& func) const {
+    each(NoFilter{}, std::forward<Func>(func));
+}
+
+template<typename... Components>
+template<typename Filter, typename Func>
+void Query<Components...>::forEach(const Filter& filter, Func&& func) {
+    each(filter, std::forward<Func>(func));
+}
+
+template<typename... Components>
+template<typename Filter, typename Func>
+void Query<Components...>::forEach(const Filter& filter, Func&& func) const {
+    each(filter, std::forward<Func>(func));
+}
+
+template<typename... Components>
+template<typename Filter>
+const ComponentTicks* Query<Components...>::getFilterTicks(const Filter& filter, const Archetype& archetype) const {
+    using FilterComponent = typename Filter::Component;
+    ComponentID typeID = ComponentType<FilterComponent>::id();
+
+    if constexpr (isSparseComponent<FilterComponent>) {
+        // Rows are matched one by one through the pool; only the pool-wide tick can rule the archetype out.
+        const SparseSetBase* pool = typeID < m_world->m_sparseSets.size() ? m_world->m_sparseSets[typeID].get() : nullptr;
+        return pool && filter.matches(pool->getPoolTicks()) ? pool->ticks() : nullptr;
+    }
+    else {
+        const ComponentColumn* column = archetype.getColumn(typeID);
+        return column && filter.matches(column->getColumnTicks()) ? column->ticks() : nullptr;
+    }
+}
+
+template<typename... Components>
+template<typename Filter>
+bool Query<Components...>::matchesRow(const Filter& filter, const ComponentTicks* ticks, EntityID entityID, size_t row) const {
+    using FilterComponent = typename Filter::Component;
+
+    if constexpr (isSparseComponent<FilterComponent>) {
+        const SparseSetBase* pool = m_world->m_sparseSets[ComponentType<FilterComponent>::id()].get();
+        std::uint32_t index = pool->indexOf(entityID);
+        return index != SparseSetBase::INVALID_INDEX && filter.matches(ticks[index]);
+    }
+    else {
+        return filter.matches(ticks[row]);
+    }
+}
+
+template<typename... Components>
+template<typename Filter, typename Func>
+void Query<Components...>::each(const Filter& filter, Func&& func) {
+    (m_world->checkAccess<Components>(!std::is_const_v<Components>), ...);
+
+    if constexpr (HAS_SPARSE) {
+        const SparseSetBase* driver = m_world->findSmallestSparseSet<Components...>();
+        if (!driver) {
+            return;
+        }
+
+        // Walk backwards so swap-and-pop removals from the driving pool inside `func` are safe.
+        const std::vector<EntityID>& entities = driver->getEntities();
+        for (size_t i = entities.size(); i-- > 0;) {
+            EntityID entityID = entities[i];
+            if ((m_world->hasComponent<Components>(entityID) && ...) && m_world->matchesFilter(filter, entityID)) {
+                func(entityID, *m_world->getComponent<Components>(entityID)...);
+            }
+        }
+    }
+    else {
+        const Tick tick = m_world->getChangeTick();
+        for (size_t i = 0; i < m_archetypes.size(); i++) {
+            Archetype* archetype = m_archetypes[i];
+            if (archetype->empty()) {
+                continue;
+            }
+
+            [[maybe_unused]] const ComponentTicks* filterTicks = nullptr;
+            if constexpr (!std::is_same_v<Filter, NoFilter>) {
+                filterTicks = getFilterTicks(filter, *archetype);
+                if (!filterTicks) {
+                    continue;
+                }
+            }
+
+            const EntityID* entities = archetype->getEntities().data();
+            const size_t count = archetype->size();
+            auto columns = getColumns(*archetype, std::index_sequence_for<Components...>{});
+            [[maybe_unused]] auto writeTicks = getWriteTicks(*archetype, std::index_sequence_for<Components...>{});
+            bool visited = false;
+            for (size_t row = 0; row < count; row++) {
+                if constexpr (!std::is_same_v<Filter, NoFilter>) {
+                    if (!matchesRow(filter, filterTicks, entities[row], row)) {
+                        continue;
+                    }
+                }
+                if constexpr (HAS_WRITES) {
+                    for (ComponentTicks* ticks : writeTicks) {
+                        if (ticks) {
+                            ticks[row].changed = tick;
+                        }
+                    }
+                }
+                visited = true;
+                std::apply([&](auto*... data) { func(entities[row], rowOf(data, row)...); }, columns);
+            }
+
+            if (HAS_WRITES && visited) {
+                markColumnsChanged(*archetype, tick);
+            }
         }
     }
+}
 
-    return result;
+template<typename... Components>
+template<typename Filter, typename Func>
+void Query<Components...>::each(const Filter& filter, Func&& func) const {
+    const World* world = m_world;
+    (world->checkAccess<Components>(false), ...);
+
+    if constexpr (HAS_SPARSE) {
+        const SparseSetBase* driver = world->findSmallestSparseSet<Components...>();
+        if (!driver) {
+            return;
+        }
+
+        const std::vector<EntityID>& entities = driver->getEntities();
+        for (size_t i = entities.size(); i-- > 0;) {
+            EntityID entityID = entities[i];
+            if ((world->hasComponent<Components>(entityID) && ...) && world->matchesFilter(filter, entityID)) {
+                func(entityID, *world->getComponent<Components>(entityID)...);
+            }
+        }
+    }
+    else {
+        for (const Archetype* archetype : m_archetypes) {
+            if (archetype->empty()) {
+                continue;
+            }
+
+            [[maybe_unused]] const ComponentTicks* filterTicks = nullptr;
+            if constexpr (!std::is_same_v<Filter, NoFilter>) {
+                filterTicks = getFilterTicks(filter, *archetype);
+                if (!filterTicks) {
+                    continue;
+                }
+            }
+
+            const EntityID* entities = archetype->getEntities().data();
+            const size_t count = archetype->size();
+            auto columns = getColumns(*archetype, std::index_sequence_for<Components...>{});
+            for (size_t row = 0; row < count; row++) {
+                if constexpr (!std::is_same_v<Filter, NoFilter>) {
+                    if (!matchesRow(filter, filterTicks, entities[row], row)) {
+                        continue;
+                    }
+                }
+                std::apply([&](const auto*... data) { func(entities[row], rowOf(data, row)...); }, columns);
+            }
+        }
+    }
 }
 
-template<typename... Components, typename Func>
-void World::forEach(Func&& func) {
-    for (const auto& entityID : m_entities) {
-        if ((hasComponent<Components>(entityID) && ...)) {
-            func(entityID, *getComponent<Components>(entityID)...);
+template<typename... Components>
+template<typename Func>
+void Query<Components...>::parallelForEach(JobSystem& jobs, Func&& func, bool deterministic) {
+    (m_world->checkAccess<Components>(!std::is_const_v<Components>), ...);
+
+    if constexpr (HAS_SPARSE) {
+        const SparseSetBase* driver = m_world->findSmallestSparseSet<Components...>();
+        if (!driver) {
+            return;
+        }
+
+        // As below, pool and column ticks are raised up front so workers only write per-entity ticks.
+        // Every matching archetype is stamped, which may include some no entity in the pools lives in.
+        const Tick tick = m_world->getChangeTick();
+        if (HAS_WRITES && !driver->empty()) {
+            auto stamp = [&](auto* type, ComponentID typeID) {
+                using T = std::remove_pointer_t<decltype(type)>;
+                if constexpr (std::is_const_v<T> || isTagComponent<T>) {
+                    return;
+                }
+                else if constexpr (isSparseComponent<T>) {
+                    m_world->stampPoolChanged(*m_world->template getSparseSet<T>(typeID), tick);
+                }
+                else {
+                    for (Archetype* archetype : m_archetypes) {
+                        if (!archetype->empty()) {
+                            m_world->stampColumnChanged(*archetype->getColumn(typeID), tick);
+                        }
+                    }
+                }
+            };
+            size_t i = 0;
+            (stamp(static_cast<Components*>(nullptr), m_typeIDs[i++]), ...);
         }
+
+        const std::vector<EntityID>& entities = driver->getEntities();
+        m_world->parallelFor(jobs, entities.size(), PARALLEL_CHUNK_ROWS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                EntityID entityID = entities[i];
+                if ((m_world->hasComponent<Components>(entityID) && ...)) {
+                    func(entityID, *m_world->template getComponentForWorker<Components>(entityID, tick)...);
+                }
+            }
+        }, deterministic);
+    }
+    else {
+        struct Chunk {
+            Archetype* archetype;
+            size_t begin;
+            size_t end;
+        };
+
+        // Column-level ticks are raised here, up front, so workers only ever write their own rows.
+        const Tick tick = m_world->getChangeTick();
+        std::vector<Chunk> chunks;
+        for (Archetype* archetype : m_archetypes) {
+            if (HAS_WRITES && !archetype->empty()) {
+                markColumnsChanged(*archetype, tick);
+            }
+            for (size_t begin = 0; begin < archetype->size(); begin += PARALLEL_CHUNK_ROWS) {
+                chunks.push_back(Chunk{ archetype, begin, std::min(begin + PARALLEL_CHUNK_ROWS, archetype->size()) });
+            }
+        }
+
+        m_world->parallelFor(jobs, chunks.size(), 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) {
+                const Chunk& chunk = chunks[c];
+                const EntityID* entities = chunk.archetype->getEntities().data();
+                auto columns = getColumns(*chunk.archetype, std::index_sequence_for<Components...>{});
+                if constexpr (HAS_WRITES) {
+                    for (ComponentTicks* ticks : getWriteTicks(*chunk.archetype, std::index_sequence_for<Components...>{})) {
+                        for (size_t row = chunk.begin; ticks && row < chunk.end; row++) {
+                            ticks[row].changed = tick;
+                        }
+                    }
+                }
+                for (size_t row = chunk.begin; row < chunk.end; row++) {
+                    std::apply([&](auto*... data) { func(entities[row], rowOf(data, row)...); }, columns);
+                }
+            }
+        }, deterministic);
     }
 }
 
-template<typename... Components, typename Func>
-void World::forEach(Func&& func) const {
-    for (const auto& entityID : m_entities) {
-        if ((hasComponent<Components>(entityID) && ...)) {
-            func(entityID, *getComponent<Components>(entityID)...);
+template<typename... Components>
+template<size_t... I>
+std::array<ComponentTicks*, sizeof...(Components)> Query<Components...>::getWriteTicks(Archetype& archetype, std::index_sequence<I...>) const {
+    return { (std::is_const_v<Components> || isTagComponent<Components> ? nullptr : archetype.getColumn(m_typeIDs[I])->ticks())... };
+}
+
+template<typename... Components>
+void Query<Components...>::markColumnsChanged(Archetype& archetype, Tick tick) const {
+    size_t i = 0;
+    ((std::is_const_v<Components> || isTagComponent<Components> ? void() : m_world->stampColumnChanged(*archetype.getColumn(m_typeIDs[i]), tick), i++), ...);
+}
+
+template<typename... Components>
+template<size_t... I>
+std::tuple<Components*...> Query<Components...>::getColumns(Archetype& archetype, std::index_sequence<I...>) const {
+    return std::make_tuple(getColumnData<Components>(archetype, m_typeIDs[I])...);
+}
+
+template<typename... Components>
+template<size_t... I>
+std::tuple<const Components*...> Query<Components...>::getColumns(const Archetype& archetype, std::index_sequence<I...>) const {
+    return std::make_tuple(getColumnData<Components>(archetype, m_typeIDs[I])...);
+}
+
+template<typename... Components>
+std::vector<EntityID> Query<Components...>::getEntities() const {
+    std::vector<EntityID> result;
+
+    if constexpr (HAS_SPARSE) {
+        const World* world = m_world;
+        if (const SparseSetBase* driver = world->findSmallestSparseSet<Components...>()) {
+            for (EntityID entityID : driver->getEntities()) {
+                if ((world->hasComponent<Components>(entityID) && ...)) {
+                    result.push_back(entityID);
+                }
+            }
         }
     }
+    else {
+        result.reserve(size());
+        for (const Archetype* archetype : m_archetypes) {
+            result.insert(result.end(), archetype->getEntities().begin(), archetype->getEntities().end());
+        }
+    }
+
+    return result;
+}
+
+template<typename... Components>
+size_t Query<Components...>::size() const {
+    if constexpr (HAS_SPARSE) {
+        return getEntities().size();
+    }
+    else {
+        size_t count = 0;
+        for (const Archetype* archetype : m_archetypes) {
+            count += archetype->size();
+        }
+        return count;
+    }
 }
 
 
 template<typename T>
 void ComponentMask::set() {
-    static_assert(std::is_base_of_v<IComponent, T>, "T must inherit from IComponent");
-    ComponentID id = World::getComponentTypeID<T>();
-    if (id < MAX_COMPONENTS) {
-        m_mask.set(id);
-    }
+    set(World::getComponentTypeID<T>());
 }
 
 template<typename T>
 void ComponentMask::unset() {
-    static_assert(std::is_base_of_v<IComponent, T>, "T must inherit from IComponent");
-    ComponentID id = World::getComponentTypeID<T>();
-    if (id < MAX_COMPONENTS) {
-        m_mask.reset(id);
-    }
+    reset(World::getComponentTypeID<T>());
 }
 
 template<typename T>
 bool ComponentMask::has() const {
-    static_assert(std::is_base_of_v<IComponent, T>, "T must inherit from IComponent");
-    ComponentID id = World::getComponentTypeID<T>();
-    return id < MAX_COMPONENTS && m_mask.test(id);
+    return test(World::getComponentTypeID<T>());
 }
 
 template<typename T>
 ComponentID ComponentMask::getComponentTypeID() {
     return World::getComponentTypeID<T>();
 }
+
+template<typename T>
+void World::writeSparseSnapshot(SnapshotWriter& out) const {
+    const SparseSet<T>* pool = getSparseSet<T>(getComponentTypeID<T>());
+    out.write(static_cast<std::uint32_t>(pool ? pool->size() : 0));
+    if (!pool || pool->empty()) {
+        return;
+    }
+
+    out.writeBytes(pool->getEntities().data(), pool->size() * sizeof(EntityID));
+    if constexpr (hasComponentSerializer<T>) {
+        for (size_t i = 0; i < pool->size(); i++) {
+            ComponentSerializer<T>::write(out, pool->data()[i]);
+        }
+    }
+    else {
+        out.writeBytes(pool->data(), pool->size() * sizeof(T));
+    }
+}
+
+template<typename T>
+void World::readSparseSnapshot(SnapshotReader& in) {
+    std::vector<EntityID> entities(in.read<std::uint32_t>());
+    if (entities.size() > in.remaining() / sizeof(EntityID)) {
+        in.skip(in.remaining() + 1);
+        return;
+    }
+    in.readBytes(entities.data(), entities.size() * sizeof(EntityID));
+
+    ComponentID typeID = getComponentTypeID<T>();
+    SparseSet<T>& pool = assureSparseSet<T>(typeID);
+    pool.reserve(pool.size() + entities.size());
+    const Tick tick = getChangeTick();
+    for (EntityID entityID : entities) {
+        T value = [&in]() {
+            if constexpr (hasComponentSerializer<T>) {
+                return ComponentSerializer<T>::read(in);
+            }
+            else {
+                return in.read<T>();
+            }
+        }();
+        if (EntityRecord* record = findRecord(entityID)) {
+            pool.emplace(entityID, tick, std::move(value));
+            record->sparseMask.set(typeID);
+        }
+    }
+}
+
+// Registration is not synchronised; register every snapshot component during startup.
+template<typename T>
+void SnapshotRegistry::registerComponent(const std::string& name) {
+    static_assert(std::is_trivially_copyable_v<T> || hasComponentSerializer<T>,
+        "Components that are not trivially copyable need a ComponentSerializer<T> specialisation");
+
+    auto info = std::make_unique<SnapshotComponentInfo>();
+    info->name = name;
+    info->typeID = World::getComponentTypeID<T>();
+    info->typeInfo = &getComponentTypeInfo<T>();
+    info->sparse = isSparseComponent<T>;
+    info->raw = !hasComponentSerializer<T>;
+    info->writeElements = [](SnapshotWriter& out, const void* data, size_t count) {
+        if constexpr (hasComponentSerializer<T>) {
+            for (size_t i = 0; i < count; i++) {
+                ComponentSerializer<T>::write(out, static_cast<const T*>(data)[i]);
+            }
+        }
+        else {
+            out.writeBytes(data, count * sizeof(T));
+        }
+    };
+    info->readElements = [](SnapshotReader& in, void* dst, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if constexpr (hasComponentSerializer<T>) {
+                new (static_cast<T*>(dst) + i) T(ComponentSerializer<T>::read(in));
+            }
+            else {
+                new (static_cast<T*>(dst) + i) T(in.read<T>());
+            }
+        }
+    };
+    info->writeSparse = [](const World& world, SnapshotWriter& out) {
+        if constexpr (isSparseComponent<T>) {
+            world.writeSparseSnapshot<T>(out);
+        }
+    };
+    info->readSparse = [](World& world, SnapshotReader& in) {
+        if constexpr (isSparseComponent<T>) {
+            world.readSparseSnapshot<T>(in);
+        }
+    };
+    info->assignElement = [](SnapshotReader& in, void* dst) {
+        if constexpr (hasComponentSerializer<T>) {
+            *static_cast<T*>(dst) = ComponentSerializer<T>::read(in);
+        }
+        else {
+            *static_cast<T*>(dst) = in.read<T>();
+        }
+    };
+    info->writeSparseValue = [](const World& world, SnapshotWriter& out, EntityID entityID) {
+        if constexpr (isSparseComponent<T>) {
+            const SparseSet<T>* pool = world.getSparseSet<T>(World::getComponentTypeID<T>());
+            const T* value = pool ? pool->get(entityID) : nullptr;
+            if (!value) {
+                return;
+            }
+            if constexpr (hasComponentSerializer<T>) {
+                ComponentSerializer<T>::write(out, *value);
+            }
+            else {
+                out.write(*value);
+            }
+        }
+    };
+    info->readSparseValue = [](World& world, SnapshotReader& in, EntityID entityID) {
+        if constexpr (isSparseComponent<T>) {
+            if constexpr (hasComponentSerializer<T>) {
+                world.addComponent<T>(entityID, ComponentSerializer<T>::read(in));
+            }
+            else {
+                world.addComponent<T>(entityID, in.read<T>());
+            }
+        }
+    };
+    add(std::move(info));
+}
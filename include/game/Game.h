@@ -2,8 +2,21 @@
 #include <glfw3.h>
 #include "graphics/Pipeline.h"
 #include "graphics/Shader.h"
+#include "graphics/InstanceBatcher.h"
+#include "graphics/RenderQueue.h"
+#include "graphics/StreamingBuffer.h"
+#include "core/FixedTimestep.h"
+#include "core/FramePacer.h"
+#include "ecs/World.h"
 #include <glm.hpp>
 
+// Rotates an entity's LocalTransform around the Y axis every simulation tick.
+struct Spin {
+    float radiansPerSecond = 1.0f;
+};
+
+// Runs either with a window (init + run) or headless (initHeadless + runHeadless). Headless games never
+// touch GLFW or OpenGL: only the simulation and the ECS tick, and rendering is skipped entirely.
 class Game {
 public:
     Game();
@@ -11,21 +24,66 @@ public:
     void init(GLFWwindow* window);
     void run();
     void cleanup();
+
+    // `workerThreads` sizes the World's JobSystem; 0 uses every hardware thread. Keep it small when
+    // packing several servers onto one machine.
+    void initHeadless(size_t workerThreads = 0);
+    // Runs `ticks` simulation ticks back to back and returns the achieved ticks per second. With
+    // `ticks` == 0, ticks at the tick rate until stop() is called and returns 0.
+    double runHeadless(std::uint64_t ticks = 0);
+    // Makes run() / runHeadless() return after the current tick. Safe to call from any thread.
+    void stop() { m_stopRequested.store(true, std::memory_order_relaxed); }
+
+    bool isHeadless() const { return m_headless; }
+    World& getWorld() { return m_world; }
+    // Packets submitted here are drawn, sorted, by the next render() and then discarded.
+    RenderQueue& getRenderQueue() { return m_renderQueue; }
+
+    // Creates `count` entities with transforms, in groups of a spinning root and seven children, to
+    // give the simulation something to do.
+    void spawnTestEntities(size_t count);
+
+    // Simulation ticks per second, and how many ticks one frame may run to catch up after a stall.
+    void setTickRate(double tickRate) { m_timestep.setTickRate(tickRate); }
+    void setMaxStepsPerFrame(int maxSteps) { m_timestep.setMaxStepsPerFrame(maxSteps); }
+    // Rendered frames per second; 0 leaves the frame rate uncapped.
+    void setFrameRateLimit(double frameRate) { m_pacer.setTargetFrameRate(frameRate); }
 private:
     void processInput();
     void update(float deltaTime);
-    void render();
+    // `alpha` is how far (0..1) the current time lies between the last two simulation ticks.
+    void render(float alpha);
 
     void loadShaders();
     void setupGameObjects();
+    // Simulation systems shared by both modes.
+    void setupWorld();
 
     GLFWwindow* m_window;
+    bool m_headless;
+    std::atomic<bool> m_stopRequested{ false };
 
     unsigned int m_shaderProgram;
     unsigned int m_VAO;
     unsigned int m_VBO;
 
-    float m_lastFrameTime;
+    FixedTimestep m_timestep;
+    FramePacer m_pacer;
+    double m_simulationTime;
+
+    World m_world;
 
-    Pipeline m_pipeline;
+    // Created by init(); constructing a Pipeline needs a current GL context.
+    std::unique_ptr<Pipeline> m_pipeline;
+    UniformHandle m_colorUniform;
+    // FrameUniforms for the frames in flight; created by init().
+    std::unique_ptr<StreamingBuffer> m_frameUniforms;
+    // Instance data of the render queue and the batcher, per frame in flight; created by init().
+    static constexpr size_t INSTANCE_STREAM_BYTES = 1024 * 1024;
+    std::unique_ptr<StreamingBuffer> m_instanceStream;
+    // Draw statistics are logged every STATS_LOG_INTERVAL rendered frames.
+    static constexpr std::uint64_t STATS_LOG_INTERVAL = 600;
+    std::uint64_t m_renderedFrames = 0;
+    InstanceBatcher m_batcher;
+    RenderQueue m_renderQueue;
 };
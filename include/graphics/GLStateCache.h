@@ -0,0 +1,106 @@
+#pragma once
+#include "pch.h"
+
+// Shadow copy of the GL binding and fixed-function state of the (single) context, so redundant binds
+// and state changes are skipped on the CPU instead of reaching the driver. All engine code binds
+// programs, VAOs, buffers and textures through here; anything that changes this state behind the
+// cache's back must call invalidate() afterwards.
+//
+// Element array buffer bindings belong to the bound VAO, so they are forgotten whenever the VAO changes.
+class GLStateCache {
+public:
+    static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+    static constexpr GLuint MAX_UNIFORM_BINDINGS = 16;
+
+    static void useProgram(GLuint program);
+    // The program last bound through useProgram. Not a real name after invalidate() until the next bind.
+    static GLuint getProgram() { return s_program; }
+    static void bindVertexArray(GLuint vao);
+    // Targets without a cache slot are passed straight through.
+    static void bindBuffer(GLenum target, GLuint buffer);
+    // Indexed bindings are cached for the first MAX_UNIFORM_BINDINGS uniform block binding points.
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // Supports GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY and GL_TEXTURE_CUBE_MAP.
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    static void setBlend(bool enabled);
+    static void setBlendFunc(GLenum source, GLenum destination);
+    static void setDepthTest(bool enabled);
+    static void setDepthFunc(GLenum func);
+    static void setDepthMask(bool writeEnabled);
+
+    // GL reverts bindings of deleted objects to 0; call these before deleting so the cache agrees.
+    static void onProgramDeleted(GLuint program);
+    static void onVertexArrayDeleted(GLuint vao);
+    static void onBufferDeleted(GLuint buffer);
+    static void onTextureDeleted(GLuint texture);
+
+    // Forgets everything; the next call of each kind is always issued.
+    static void invalidate();
+
+    // Counts a GL call that does not go through the cache (draws, uploads) in the frame statistics.
+    static void recordCall(size_t calls = 1) {
+#ifndef NDEBUG
+        s_frameStats.issued += calls;
+#else
+        (void)calls;
+#endif
+    }
+
+    // GL calls issued and skipped during a frame. Only counted in debug builds.
+    struct FrameStats {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    // Ends the current frame; getLastFrameStats() then describes it.
+    static void endFrame();
+    static const FrameStats& getLastFrameStats() { return s_lastFrameStats; }
+
+private:
+    // Sentinel for "unknown", which never equals a real binding.
+    static constexpr GLuint UNKNOWN = std::numeric_limits<GLuint>::max();
+
+    enum BufferSlot { ARRAY, ELEMENT_ARRAY, UNIFORM, COPY_READ, COPY_WRITE, PIXEL_UNPACK, DRAW_INDIRECT, BUFFER_SLOT_COUNT };
+    enum TextureSlot { TEXTURE_2D, TEXTURE_2D_ARRAY, TEXTURE_CUBE_MAP, TEXTURE_SLOT_COUNT };
+    enum class Toggle : std::uint8_t { UNKNOWN, OFF, ON };
+
+    struct IndexedBinding {
+        GLuint buffer;
+        GLintptr offset;
+        // -1 for glBindBufferBase, which binds the whole buffer.
+        GLsizeiptr size;
+
+        bool operator!=(const IndexedBinding& other) const {
+            return buffer != other.buffer || offset != other.offset || size != other.size;
+        }
+    };
+
+    static int getBufferSlot(GLenum target);
+    static int getTextureSlot(GLenum target);
+    static void setToggle(Toggle& cached, GLenum capability, bool enabled);
+
+    static bool count(bool issue) {
+#ifndef NDEBUG
+        (issue ? s_frameStats.issued : s_frameStats.skipped)++;
+#endif
+        return issue;
+    }
+
+    static GLuint s_program;
+    static GLuint s_vertexArray;
+    static std::array<GLuint, BUFFER_SLOT_COUNT> s_buffers;
+    static std::array<IndexedBinding, MAX_UNIFORM_BINDINGS> s_uniformBindings;
+    static GLuint s_activeTextureUnit;
+    static std::array<std::array<GLuint, TEXTURE_SLOT_COUNT>, MAX_TEXTURE_UNITS> s_textures;
+    static Toggle s_blend;
+    static GLenum s_blendSource;
+    static GLenum s_blendDestination;
+    static Toggle s_depthTest;
+    static GLenum s_depthFunc;
+    static Toggle s_depthMask;
+
+    static FrameStats s_frameStats;
+    static FrameStats s_lastFrameStats;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include "pch.h"
+#include "graphics/Mesh.h"
+#include "graphics/Pipeline.h"
+#include "ecs/World.h"
+#include "ecs/Hierarchy.h"
+
+// Draws an entity's WorldTransform with `mesh` and `pipeline`. Both are borrowed and must outlive the
+// component; the pipeline's vertex shader must read InstanceData from the locations given in Mesh.h.
+struct MeshRenderer {
+    Mesh* mesh = nullptr;
+    const Pipeline* pipeline = nullptr;
+    glm::vec4 color{ 1.0f };
+};
+
+// Groups every entity with a MeshRenderer and a WorldTransform by (pipeline, mesh) and draws each
+// group with a single Mesh::drawInstanced call. Groups are drawn ordered by pipeline, so each program
+// is bound once per frame. Instances are written into a StreamingBuffer region when one is given.
+class InstanceBatcher {
+public:
+    // Collects this frame's instances. Batch storage is reused between frames while the batch stays in use.
+    void build(World& world);
+    // `stream` must be between beginFrame() and endFrame(). Batches that do not fit in its region are
+    // drawn through the mesh's own instance buffer.
+    void draw(StreamingBuffer* stream = nullptr);
+
+    size_t getBatchCount() const { return m_batches.size(); }
+    size_t getInstanceCount() const { return m_instanceCount; }
+
+    // What the last draw() issued: instanced draw calls, the instance bytes they uploaded or wrote into
+    // the stream, and how many of the draws had to use the mesh's fallback buffer.
+    struct DrawStats {
+        size_t drawCalls = 0;
+        size_t uploadBytes = 0;
+        size_t fallbackDraws = 0;
+    };
+    const DrawStats& getDrawStats() const { return m_drawStats; }
+
+private:
+    struct BatchKey {
+        const Pipeline* pipeline;
+        Mesh* mesh;
+
+        bool operator<(const BatchKey& other) const {
+            return pipeline != other.pipeline ? std::less<const Pipeline*>()(pipeline, other.pipeline)
+                : std::less<Mesh*>()(mesh, other.mesh);
+        }
+    };
+
+    struct Batch {
+        BatchKey key;
+        std::vector<InstanceData> instances;
+    };
+
+    // Ordered by key, so iterating it yields batches grouped by pipeline.
+    std::map<BatchKey, size_t> m_batchIndices;
+    std::vector<Batch> m_batches;
+    // Where each batch's instances went in the stream this frame, parallel to m_batches.
+    std::vector<StreamingBuffer::Allocation> m_allocations;
+    size_t m_instanceCount = 0;
+    DrawStats m_drawStats;
+};
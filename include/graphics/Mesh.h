@@ -1,5 +1,7 @@
 #pragma once
 #include "pch.h"
+#include "graphics/GLStateCache.h"
+#include "graphics/StreamingBuffer.h"
 
 struct Vertex {
     float position[3]; // x, y, z
@@ -7,6 +9,13 @@ struct Vertex {
     float texCoords[2]; // u, v
 };
 
+// Per-instance attributes for Mesh::drawInstanced. Vertex shaders read the model matrix from
+// locations 3-6 (one column each) and the color from location 7.
+struct InstanceData {
+    glm::mat4 model{ 1.0f };
+    glm::vec4 color{ 1.0f };
+};
+
 class Mesh {
 public:
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
@@ -14,19 +23,30 @@ public:
         setupMesh();
     }
     ~Mesh() {
+        GLStateCache::onVertexArrayDeleted(m_VAO);
+        GLStateCache::onBufferDeleted(m_VBO);
+        GLStateCache::onBufferDeleted(m_EBO);
+        GLStateCache::onBufferDeleted(m_instanceVBO);
         glDeleteVertexArrays(1, &m_VAO);
         glDeleteBuffers(1, &m_VBO);
         glDeleteBuffers(1, &m_EBO);
+        glDeleteBuffers(1, &m_instanceVBO);
     }
 
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
     Mesh(Mesh&& other) noexcept
         : m_vertices(std::move(other.m_vertices)), m_indices(std::move(other.m_indices)),
-        m_VAO(other.m_VAO), m_VBO(other.m_VBO), m_EBO(other.m_EBO) {
+        m_VAO(other.m_VAO), m_VBO(other.m_VBO), m_EBO(other.m_EBO),
+        m_instanceVBO(other.m_instanceVBO), m_instanceCapacity(other.m_instanceCapacity),
+        m_instanceAttributesEnabled(other.m_instanceAttributesEnabled),
+        m_instanceSource(other.m_instanceSource), m_instanceSourceOffset(other.m_instanceSourceOffset) {
         other.m_VAO = 0;
         other.m_VBO = 0;
         other.m_EBO = 0;
+        other.m_instanceVBO = 0;
+        other.m_instanceCapacity = 0;
+        other.m_instanceAttributesEnabled = false;
     }
     Mesh& operator=(Mesh&& other) noexcept {
         if (this != &other) {
@@ -35,20 +55,59 @@ public:
             m_VAO = other.m_VAO;
             m_VBO = other.m_VBO;
             m_EBO = other.m_EBO;
+            m_instanceVBO = other.m_instanceVBO;
+            m_instanceCapacity = other.m_instanceCapacity;
+            m_instanceAttributesEnabled = other.m_instanceAttributesEnabled;
+            m_instanceSource = other.m_instanceSource;
+            m_instanceSourceOffset = other.m_instanceSourceOffset;
             other.m_VAO = 0;
             other.m_VBO = 0;
             other.m_EBO = 0;
+            other.m_instanceVBO = 0;
+            other.m_instanceCapacity = 0;
+            other.m_instanceAttributesEnabled = false;
         }
         return *this;
     }
     void bind() const;
     void unbind() const;
     void draw() const;
+    unsigned int getVAO() const { return m_VAO; }
+    // Draws `count` instances that were written to `allocation`, which must come from
+    // stream.allocateElements(count, sizeof(InstanceData)) and have been flushed. On GL 4.2+ the
+    // instance attributes keep pointing at the start of the stream and the draw selects the range with
+    // its base instance; older contexts re-point the attributes when the offset changes.
+    void drawInstanced(const StreamingBuffer& stream, const StreamingBuffer::Allocation& allocation, size_t count);
+    // Copies the instances into `stream` and draws them from there. Without a stream, or when its
+    // region is full, they are uploaded with glBufferSubData to a per-mesh instance buffer instead,
+    // which is only reallocated when it has to grow.
+    void drawInstanced(const InstanceData* instances, size_t count, StreamingBuffer* stream = nullptr);
+    void drawInstanced(const std::vector<InstanceData>& instances, StreamingBuffer* stream = nullptr) {
+        drawInstanced(instances.data(), instances.size(), stream);
+    }
+
+    static constexpr GLuint INSTANCE_MODEL_LOCATION = 3;
+    static constexpr GLuint INSTANCE_COLOR_LOCATION = 7;
+
+    // Checks that the linked `program` reads InstanceData as laid out above: a mat4 at the model
+    // location, a vec4 at the color location if it uses one, and nothing else in between. Logs what
+    // is wrong and returns false otherwise. Queries the program, so meant for debug builds.
+    static bool checkInstanceLayout(GLuint program);
 
 private:
     void setupMesh();
+    // Points the instance attributes of the VAO at `offset` bytes into `buffer`, enabling them on first use.
+    void setInstanceSource(GLuint buffer, GLintptr offset);
+    void drawInstancedFallback(const InstanceData* instances, size_t count);
     std::vector<Vertex> m_vertices;
     std::vector<unsigned int> m_indices;
     unsigned int m_VAO, m_VBO, m_EBO;
+    // Fallback instance buffer, created on the first draw that needs it.
+    unsigned int m_instanceVBO = 0;
+    size_t m_instanceCapacity = 0;
+    // What the VAO's instance attributes currently read from.
+    bool m_instanceAttributesEnabled = false;
+    GLuint m_instanceSource = 0;
+    GLintptr m_instanceSourceOffset = 0;
 
 };
\ No newline at end of file
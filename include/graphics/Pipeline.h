@@ -2,10 +2,18 @@
 #include "pch.h"
 #include <glad/glad.h>
 #include "Shader.h"
+#include "GLStateCache.h"
 #include <spdlog/spdlog.h>
 #include <glm.hpp>
 #include <memory> // Required for std::unique_ptr
 
+// A uniform location resolved once with Pipeline::getUniformHandle, so per-frame setters skip the
+// name lookup. Only valid for the pipeline that produced it.
+struct UniformHandle {
+    GLint location = -1;
+    bool isValid() const { return location != -1; }
+};
+
 class Pipeline {
 public:
     Pipeline();
@@ -22,15 +30,34 @@ public:
     void detachShader(std::unique_ptr<Shader> shader);
     void detachAllShaders();
 
+    // Binds through GLStateCache, so using the current program again costs nothing.
     void use() const;
-    static void disuse() { glUseProgram(0); }
+    static void disuse() { GLStateCache::useProgram(0); }
 
     // Getters
     GLuint getID() const { return m_programID; }
     bool isLinked() const { return m_isLinked; }
     const std::string& getInfoLog() const { return m_infoLog; }
 
-    // Uniform setters
+    // Binds the uniform block `blockName` to binding point `binding`. Returns false if the program has
+    // no such block. link() already does this for the blocks in UniformBlocks.h.
+    bool bindUniformBlock(const char* blockName, GLuint binding) const;
+
+    UniformHandle getUniformHandle(const std::string& name) const { return UniformHandle{ getUniformLocation(name) }; }
+
+    // Uniform setters. glUniform* writes to the current program, so call use() first; debug builds log
+    // an error when this pipeline is not the bound program. Invalid handles are ignored.
+    void setUniform(UniformHandle handle, int value) const;
+    void setUniform(UniformHandle handle, float value) const;
+    void setUniform(UniformHandle handle, bool value) const;
+    void setUniform(UniformHandle handle, const glm::vec2& value) const;
+    void setUniform(UniformHandle handle, const glm::vec3& value) const;
+    void setUniform(UniformHandle handle, const glm::vec4& value) const;
+    void setUniform(UniformHandle handle, const glm::mat3& value) const;
+    void setUniform(UniformHandle handle, const glm::mat4& value) const;
+
+    // Convenience overloads that look the name up in a per-pipeline cache on every call; prefer handles
+    // for anything set per frame.
     void setUniform(const std::string& name, int value) const;
     void setUniform(const std::string& name, float value) const;
     void setUniform(const std::string& name, bool value) const; // Often implemented as int uniform
@@ -43,6 +70,7 @@ public:
 
 private:
     GLint getUniformLocation(const std::string& name) const;
+    void checkCurrent() const;
     GLuint m_programID;
     bool m_isLinked;
     std::string m_infoLog;
@@ -0,0 +1,92 @@
+#pragma once
+#include "pch.h"
+#include "graphics/Mesh.h"
+#include "graphics/Pipeline.h"
+
+// One draw submitted to a RenderQueue. `texture` is the material's texture, bound to unit 0, or 0 for
+// none. `depth` is the view-space distance; nearer packets are drawn first within equal state.
+//
+// Every packet is drawn through Mesh::drawInstanced, merged with its neighbours or alone, so the
+// pipeline's vertex shader must read `instance` as per-instance attributes: the model matrix as a mat4
+// at location 3 (taking 3-6) and the color as a vec4 at location 7, like instanced.vert. Debug builds
+// check this with Mesh::checkInstanceLayout when a pipeline is first submitted in a frame.
+struct RenderPacket {
+    const Pipeline* pipeline = nullptr;
+    Mesh* mesh = nullptr;
+    GLuint texture = 0;
+    float depth = 0.0f;
+    InstanceData instance;
+};
+
+// Per-frame draw list. Packets are sorted by a 64-bit key so that state changes are made as rarely as
+// possible, with program changes the most expensive and therefore the most significant bits:
+//
+//     63      52 51          36 35      24 23          0
+//     [ program ][   texture   ][   VAO   ][   depth   ]
+//
+// The program, texture and VAO fields hold dense indices handed out per frame in submission order,
+// not GL names, so names of any size get distinct keys. Only past 4096 programs or VAOs (65536
+// textures) in one frame do the indices saturate, which can merely cost extra state changes: execute()
+// compares the real objects, never the keys. Consecutive packets with identical state are merged
+// into a single instanced draw.
+class RenderQueue {
+public:
+    struct Stats {
+        size_t packets = 0;
+        size_t drawCalls = 0;
+        // Instance bytes written into the stream or uploaded, and draws that had to use Mesh's fallback.
+        size_t uploadBytes = 0;
+        size_t fallbackDraws = 0;
+        size_t programChanges = 0;
+        size_t meshChanges = 0;
+        size_t textureChanges = 0;
+        // Changes that executing the packets in submission order would have made on top of the above.
+        size_t programChangesAvoided = 0;
+        size_t meshChangesAvoided = 0;
+        size_t textureChangesAvoided = 0;
+    };
+
+    void reserve(size_t packets);
+    void submit(const RenderPacket& packet);
+    void clear();
+
+    // Sorts the packets by key. Called by execute() if needed.
+    void sort();
+    // Merged runs write their instances straight into `stream`, which must be between beginFrame() and
+    // endFrame(). Runs that do not fit, or all of them without a stream, go through Mesh's fallback.
+    void execute(StreamingBuffer* stream = nullptr);
+
+    size_t size() const { return m_packets.size(); }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    struct SortItem {
+        std::uint64_t key;
+        std::uint32_t packet;
+    };
+
+    // Assigns the packet's dense indices on first sight, so it must be called in submission order.
+    std::uint64_t makeKey(const RenderPacket& packet);
+    static std::uint64_t getDenseIndex(std::unordered_map<GLuint, std::uint32_t>& indices, GLuint name, std::uint32_t limit);
+
+    void radixSort();
+    void countChanges(size_t& programs, size_t& meshes, size_t& textures, bool sorted) const;
+
+    std::vector<RenderPacket> m_packets;
+    std::vector<SortItem> m_items;
+    std::vector<SortItem> m_scratch;
+    struct Run {
+        size_t begin;
+        size_t end;
+        StreamingBuffer::Allocation allocation;
+    };
+
+    std::vector<Run> m_runs;
+    std::vector<InstanceData> m_instances;
+    // GL name to dense key index, reset by clear().
+    std::unordered_map<GLuint, std::uint32_t> m_programIndices;
+    std::unordered_map<GLuint, std::uint32_t> m_textureIndices;
+    std::unordered_map<GLuint, std::uint32_t> m_vaoIndices;
+    bool m_sorted = true;
+    Stats m_stats;
+};
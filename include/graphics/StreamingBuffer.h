@@ -0,0 +1,72 @@
+#pragma once
+#include "pch.h"
+
+// Ring buffer for data the CPU rewrites every frame (particles, debug lines, UI, per-frame uniforms).
+// The buffer is split into `regionCount` regions, one per frame in flight. Each frame writes into the
+// next region, after waiting on the fence placed when that region was last used, so the CPU never
+// overwrites memory the GPU may still be reading.
+//
+// On GL 4.4+ the storage is allocated with glBufferStorage and stays persistently and coherently
+// mapped: allocate() returns pointers straight into GPU-visible memory. Older contexts fall back to a
+// CPU shadow copy that flush() uploads with glBufferSubData, so flush() must be called after writing
+// and before the first draw that reads the data.
+class StreamingBuffer {
+public:
+    struct Allocation {
+        void* data = nullptr;
+        // Byte offset into the whole buffer, for glBindBufferRange / vertex attribute offsets.
+        GLintptr offset = 0;
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    // `target` is what the buffer will be bound to for drawing; getTarget() hands it back.
+    StreamingBuffer(GLenum target, size_t regionSize, size_t regionCount = 3);
+    ~StreamingBuffer();
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // Moves to the next region, waiting for the GPU to finish with it if necessary.
+    void beginFrame();
+    // Returns `size` bytes in the current region, or an empty allocation if the region is full.
+    // `alignment` must be a power of two; uniform blocks need GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+    Allocation allocate(size_t size, size_t alignment = 16);
+    // Room for `count` elements of `stride` bytes whose offset is a whole number of elements from the
+    // start of the buffer, so draws can address them by index (e.g. as the base instance).
+    Allocation allocateElements(size_t count, size_t stride);
+    // Makes everything allocated so far visible to the GPU. Does nothing with a persistent mapping;
+    // otherwise uploads the bytes allocated since the last flush.
+    void flush();
+    // Fences the current region. Call after the last draw that reads from it.
+    void endFrame();
+
+    GLuint getID() const { return m_buffer; }
+    GLenum getTarget() const { return m_target; }
+    size_t getRegionSize() const { return m_regionSize; }
+    bool isPersistent() const { return m_persistent; }
+    // Number of beginFrame() calls that had to block on the GPU.
+    size_t getStallCount() const { return m_stalls; }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, the alignment to allocate uniform blocks with.
+    static size_t getUniformOffsetAlignment();
+
+private:
+    void waitForRegion(size_t region);
+
+    GLenum m_target;
+    size_t m_regionSize;
+    size_t m_regionCount;
+    GLuint m_buffer = 0;
+    bool m_persistent = false;
+    std::byte* m_mapped = nullptr;
+    // Fallback path only: staging memory for the whole buffer.
+    std::vector<std::byte> m_shadow;
+    std::vector<GLsync> m_fences;
+
+    size_t m_region = 0;
+    size_t m_used = 0;
+    // Fallback path only: bytes of the current region already uploaded.
+    size_t m_flushed = 0;
+    bool m_inFrame = false;
+    size_t m_stalls = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "pch.h"
+
+// C++ mirrors of the uniform blocks shared by all shaders. They follow std140: every member here is a
+// mat4, a vec4 or a group of four scalars, so the C++ layout matches without manual padding rules
+// (a lone vec3 would take 16 bytes in std140 but 12 here, which is why there are none).
+//
+// Shaders declare them as, e.g.
+//     layout(std140, binding = 0) uniform FrameBlock { mat4 view; ... };
+// Pipeline::link also binds blocks found under these names, for shaders without a binding qualifier.
+// Blocks are only added here together with code that writes and binds them.
+
+// Written once per frame into a StreamingBuffer region.
+struct FrameUniforms {
+    static constexpr const char* BLOCK_NAME = "FrameBlock";
+    static constexpr GLuint BINDING = 0;
+
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::mat4 viewProjection{ 1.0f };
+    float time = 0.0f;
+    float deltaTime = 0.0f;
+    // Interpolation factor between the last two simulation ticks.
+    float alpha = 0.0f;
+    float padding0 = 0.0f;
+};
+
+static_assert(sizeof(FrameUniforms) == 208 && offsetof(FrameUniforms, time) == 192, "FrameUniforms must match std140");
@@ -7,12 +7,16 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream> // Still useful for non-logging output or if spdlog uses it
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -24,6 +28,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <typeindex>
 #include <unordered_map>
 #include <unordered_set>
@@ -0,0 +1,33 @@
+#pragma once
+#include "pch.h"
+
+// Read-only memory mapping of a whole file. The contents stay valid until the object is closed or
+// destroyed; the OS pages them in on demand, so opening is cheap regardless of file size.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path) { open(path); }
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return m_open; }
+    const std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+};
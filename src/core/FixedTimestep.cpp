@@ -0,0 +1,30 @@
+#include "pch.h"
+#include "core/FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double tickRate, int maxStepsPerFrame)
+    : m_stepSeconds(1.0 / 60.0), m_maxStepsPerFrame(std::max(maxStepsPerFrame, 1)) {
+    setTickRate(tickRate);
+}
+
+void FixedTimestep::setTickRate(double tickRate) {
+    if (tickRate <= 0.0) {
+        LOG_ERROR("FixedTimestep::setTickRate: Tick rate must be positive, got {}.", tickRate);
+        return;
+    }
+    m_stepSeconds = 1.0 / tickRate;
+}
+
+int FixedTimestep::advance(double elapsedSeconds) {
+    m_accumulator += std::max(elapsedSeconds, 0.0);
+
+    int steps = static_cast<int>(m_accumulator / m_stepSeconds);
+    if (steps > m_maxStepsPerFrame) {
+        LOG_WARN("FixedTimestep::advance: Dropping {:.1f}ms of simulation time to catch up.",
+            (m_accumulator - m_maxStepsPerFrame * m_stepSeconds) * 1000.0);
+        steps = m_maxStepsPerFrame;
+        m_accumulator = m_maxStepsPerFrame * m_stepSeconds;
+    }
+    m_accumulator -= steps * m_stepSeconds;
+    m_tickCount += static_cast<std::uint64_t>(steps);
+    return steps;
+}
@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "core/FramePacer.h"
+
+FramePacer::FramePacer(double targetFrameRate) {
+    setTargetFrameRate(targetFrameRate);
+}
+
+void FramePacer::setTargetFrameRate(double targetFrameRate) {
+    m_targetFrameRate = std::max(targetFrameRate, 0.0);
+    m_frameDuration = m_targetFrameRate > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFrameRate))
+        : Clock::duration::zero();
+    reset();
+}
+
+void FramePacer::wait() {
+    if (m_frameDuration == Clock::duration::zero()) {
+        return;
+    }
+
+    // Sleep until just before the deadline, leaving as much slack as the OS recently overshot by, and
+    // yield through the rest. The slack is capped at a quarter frame so one huge overshoot (a debugger
+    // break, a suspended process) cannot turn every later frame into a yield-spin.
+    bool slept = false;
+    for (auto now = Clock::now();; now = Clock::now()) {
+        auto slack = std::min(m_sleepOvershoot, m_frameDuration / 4);
+        if (m_nextFrame - now <= slack) {
+            break;
+        }
+        auto requested = m_nextFrame - now - slack;
+        std::this_thread::sleep_for(requested);
+        slept = true;
+        auto overshoot = std::max(Clock::now() - now - requested, Clock::duration::zero());
+        // Jump up to a larger overshoot immediately, decay slowly towards smaller ones. The estimate
+        // itself is clamped as well, so an outlier decays from the cap rather than from its own size.
+        m_sleepOvershoot = overshoot > m_sleepOvershoot ? overshoot : (m_sleepOvershoot * 15 + overshoot) / 16;
+        m_sleepOvershoot = std::min(m_sleepOvershoot, m_frameDuration / 4);
+    }
+    if (!slept) {
+        // No new measurement this frame; let the estimate decay so it cannot stay stuck.
+        m_sleepOvershoot = m_sleepOvershoot * 15 / 16;
+    }
+    while (Clock::now() < m_nextFrame) {
+        std::this_thread::yield();
+    }
+
+    m_nextFrame += m_frameDuration;
+    // After a long frame, restart the grid instead of rushing through the missed frames.
+    auto now = Clock::now();
+    if (m_nextFrame < now) {
+        m_nextFrame = now + m_frameDuration;
+    }
+}
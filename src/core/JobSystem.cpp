@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "core/JobSystem.h"
+
+thread_local const JobSystem* JobSystem::t_owner = nullptr;
+thread_local size_t JobSystem::t_threadIndex = 0;
+
+JobSystem::JobSystem(size_t workerCount) {
+    if (workerCount == 0) {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    // Queue 0 belongs to external threads; queues 1..workerCount to the workers.
+    for (size_t i = 0; i <= workerCount; i++) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 1; i <= workerCount; i++) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+    LOG_INFO("JobSystem::JobSystem: Started {} worker threads.", workerCount);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+size_t JobSystem::getCurrentThreadIndex() const {
+    return t_owner == this ? t_threadIndex : 0;
+}
+
+void JobSystem::submit(Job job, JobCounter& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    WorkQueue& queue = *m_queues[getCurrentThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{ std::move(job), &counter });
+    }
+    m_queuedTasks.fetch_add(1, std::memory_order_release);
+    notifyWorkers();
+}
+
+void JobSystem::submitTo(size_t threadIndex, Job job, JobCounter& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    WorkQueue& queue = *m_queues[threadIndex % m_queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pinned.push_back(Task{ std::move(job), &counter });
+    }
+    m_queuedTasks.fetch_add(1, std::memory_order_release);
+    notifyWorkers();
+}
+
+void JobSystem::notifyWorkers() {
+    // Taking the lock orders this notify after any worker's predicate check, so no wakeup is lost.
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_wake.notify_all();
+}
+
+void JobSystem::wait(const JobCounter& counter) {
+    size_t threadIndex = getCurrentThreadIndex();
+    while (counter.load(std::memory_order_acquire) > 0) {
+        if (!runOne(threadIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+    grainSize = std::max<size_t>(grainSize, 1);
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    if (chunkCount == 1) {
+        func(0, count);
+        return;
+    }
+
+    JobCounter counter{ 0 };
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        size_t begin = chunk * grainSize;
+        size_t end = std::min(begin + grainSize, count);
+        submit([&func, begin, end]() { func(begin, end); }, counter);
+    }
+
+    wait(counter);
+}
+
+bool JobSystem::runOne(size_t threadIndex) {
+    Task task;
+    bool found = false;
+
+    {
+        WorkQueue& own = *m_queues[threadIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.pinned.empty()) {
+            task = std::move(own.pinned.front());
+            own.pinned.pop_front();
+            found = true;
+        }
+        else if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    for (size_t offset = 1; !found && offset < m_queues.size(); offset++) {
+        WorkQueue& victim = *m_queues[(threadIndex + offset) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    execute(task);
+    return true;
+}
+
+void JobSystem::execute(Task& task) {
+    task.job();
+    task.counter->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::workerLoop(size_t threadIndex) {
+    t_owner = this;
+    t_threadIndex = threadIndex;
+
+    while (true) {
+        if (runOne(threadIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stop) {
+            return;
+        }
+        if (m_queuedTasks.load(std::memory_order_acquire) == 0) {
+            m_wake.wait(lock, [this]() { return m_stop || m_queuedTasks.load(std::memory_order_acquire) > 0; });
+        }
+        else {
+            // Work exists but is pinned to other threads.
+            lock.unlock();
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,224 @@
+#include "ecs/Archetype.h"
+
+
+ComponentColumn::~ComponentColumn() {
+    clear();
+    ::operator delete(m_data, std::align_val_t(m_info->alignment));
+}
+
+ComponentColumn::ComponentColumn(ComponentColumn&& other) noexcept
+    : m_info(other.m_info), m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity),
+      m_ticks(std::move(other.m_ticks)), m_columnTicks(other.m_columnTicks) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
+}
+
+ComponentColumn& ComponentColumn::operator=(ComponentColumn&& other) noexcept {
+    if (this != &other) {
+        clear();
+        ::operator delete(m_data, std::align_val_t(m_info->alignment));
+        m_info = other.m_info;
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        m_ticks = std::move(other.m_ticks);
+        m_columnTicks = other.m_columnTicks;
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+    return *this;
+}
+
+void ComponentColumn::relocate(void* dst, void* src) const {
+    if (m_info->trivial) {
+        std::memcpy(dst, src, m_info->size);
+    }
+    else {
+        m_info->moveConstruct(dst, src);
+        m_info->destroy(src);
+    }
+}
+
+void ComponentColumn::reserve(size_t capacity) {
+    if (capacity <= m_capacity) {
+        return;
+    }
+    m_ticks.reserve(capacity);
+
+    auto* data = static_cast<std::byte*>(::operator new(capacity * m_info->size, std::align_val_t(m_info->alignment)));
+    if (m_info->trivial) {
+        if (m_size > 0) {
+            std::memcpy(data, m_data, m_size * m_info->size);
+        }
+    }
+    else {
+        for (size_t i = 0; i < m_size; i++) {
+            relocate(data + i * m_info->size, m_data + i * m_info->size);
+        }
+    }
+
+    ::operator delete(m_data, std::align_val_t(m_info->alignment));
+    m_data = data;
+    m_capacity = capacity;
+}
+
+void* ComponentColumn::pushUninitialized() {
+    if (m_size == m_capacity) {
+        reserve(m_capacity ? m_capacity * 2 : 16);
+    }
+    m_ticks.emplace_back();
+    return m_data + m_size++ * m_info->size;
+}
+
+void* ComponentColumn::appendUninitialized(size_t count, Tick tick) {
+    reserve(m_size + count);
+    m_ticks.resize(m_size + count, ComponentTicks{ tick, tick });
+    if (count > 0) {
+        m_columnTicks = ComponentTicks{ tick, tick };
+    }
+    void* first = m_data + m_size * m_info->size;
+    m_size += count;
+    return first;
+}
+
+void ComponentColumn::moveElementTo(size_t row, ComponentColumn& dst) {
+    void* slot = dst.pushUninitialized();
+    if (m_info->trivial) {
+        std::memcpy(slot, get(row), m_info->size);
+    }
+    else {
+        m_info->moveConstruct(slot, get(row));
+    }
+
+    const ComponentTicks& ticks = m_ticks[row];
+    dst.m_ticks.back() = ticks;
+    dst.m_columnTicks.added = std::max(dst.m_columnTicks.added, ticks.added);
+    dst.m_columnTicks.changed = std::max(dst.m_columnTicks.changed, ticks.changed);
+}
+
+void ComponentColumn::swapRemove(size_t row) {
+    size_t last = m_size - 1;
+    if (!m_info->trivial) {
+        m_info->destroy(get(row));
+    }
+    if (row != last) {
+        relocate(get(row), get(last));
+        m_ticks[row] = m_ticks[last];
+    }
+    m_ticks.pop_back();
+    m_size--;
+}
+
+void ComponentColumn::clear() {
+    if (!m_info->trivial) {
+        for (size_t i = 0; i < m_size; i++) {
+            m_info->destroy(get(i));
+        }
+    }
+    m_size = 0;
+    m_ticks.clear();
+}
+
+
+void Archetype::addColumn(ComponentID typeID, const ComponentTypeInfo& info) {
+    if (typeID >= m_columnIndex.size()) {
+        LOG_ERROR("Archetype::addColumn: Component type ID {} exceeds the maximum of {}.", typeID, m_columnIndex.size());
+        return;
+    }
+    if (hasColumn(typeID)) {
+        LOG_WARN("Archetype::addColumn: Column for component type ID {} already exists.", typeID);
+        return;
+    }
+    m_columnIndex[typeID] = static_cast<std::int16_t>(m_columns.size());
+    m_columnTypes.push_back(typeID);
+    m_columns.emplace_back(info);
+}
+
+std::unique_ptr<Archetype> Archetype::createWith(ComponentID typeID, const ComponentTypeInfo& info) const {
+    ComponentMask mask = m_mask;
+    mask.set(typeID);
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        archetype->addColumn(m_columnTypes[i], m_columns[i].getTypeInfo());
+    }
+    if (!info.tag) {
+        archetype->addColumn(typeID, info);
+    }
+    return archetype;
+}
+
+std::unique_ptr<Archetype> Archetype::createWithout(ComponentID typeID) const {
+    ComponentMask mask = m_mask;
+    mask.reset(typeID);
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        if (m_columnTypes[i] != typeID) {
+            archetype->addColumn(m_columnTypes[i], m_columns[i].getTypeInfo());
+        }
+    }
+    return archetype;
+}
+
+size_t Archetype::pushEntity(EntityID entityID) {
+    m_entities.push_back(entityID);
+    return m_entities.size() - 1;
+}
+
+EntityID* Archetype::appendRows(size_t count) {
+    size_t first = m_entities.size();
+    m_entities.resize(first + count);
+    return m_entities.data() + first;
+}
+
+EntityID Archetype::moveRowTo(size_t row, Archetype& dst) {
+    dst.pushEntity(m_entities[row]);
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        if (ComponentColumn* dstColumn = dst.getColumn(m_columnTypes[i])) {
+            m_columns[i].moveElementTo(row, *dstColumn);
+        }
+    }
+    return removeRow(row);
+}
+
+EntityID Archetype::removeRow(size_t row) {
+    for (auto& column : m_columns) {
+        column.swapRemove(row);
+    }
+
+    size_t last = m_entities.size() - 1;
+    if (row != last) {
+        m_entities[row] = m_entities[last];
+        m_entities.pop_back();
+        return m_entities[row];
+    }
+    m_entities.pop_back();
+    return NULL_ENTITY_ID;
+}
+
+void Archetype::reserve(size_t capacity) {
+    m_entities.reserve(capacity);
+    for (auto& column : m_columns) {
+        column.reserve(capacity);
+    }
+}
+
+void Archetype::clear() {
+    m_entities.clear();
+    for (auto& column : m_columns) {
+        column.clear();
+    }
+}
+
+Archetype* Archetype::getAddEdge(ComponentID typeID) const {
+    auto it = m_addEdges.find(typeID);
+    return it != m_addEdges.end() ? it->second : nullptr;
+}
+
+Archetype* Archetype::getRemoveEdge(ComponentID typeID) const {
+    auto it = m_removeEdges.find(typeID);
+    return it != m_removeEdges.end() ? it->second : nullptr;
+}
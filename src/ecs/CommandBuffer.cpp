@@ -0,0 +1,157 @@
+#include "ecs/CommandBuffer.h"
+
+
+CommandBuffer::CommandBuffer(World& world) : m_world(world), m_streams(1) {
+}
+
+CommandBuffer::~CommandBuffer() {
+    clear();
+}
+
+void* CommandBuffer::Stream::allocate(size_t size, size_t alignment) {
+    if (size > PAYLOAD_BLOCK_SIZE) {
+        largeBlocks.push_back(std::make_unique<std::byte[]>(size));
+        return largeBlocks.back().get();
+    }
+
+    size_t offset = (blockUsed + alignment - 1) & ~(alignment - 1);
+    if (blockCount == 0 || offset + size > PAYLOAD_BLOCK_SIZE) {
+        if (blockCount == blocks.size()) {
+            blocks.push_back(std::make_unique<std::byte[]>(PAYLOAD_BLOCK_SIZE));
+        }
+        blockCount++;
+        offset = 0;
+    }
+    blockUsed = offset + size;
+    return blocks[blockCount - 1].get() + offset;
+}
+
+CommandBuffer::Stream& CommandBuffer::lockStream(std::unique_lock<std::mutex>& lock) {
+    if (t_chunkStream && t_chunkBuffer == this) {
+        return *t_chunkStream;
+    }
+    // Looked up on every call rather than cached, since World::setJobSystem may replace the pool.
+    JobSystem* jobs = m_world.m_jobSystem.get();
+    size_t index = jobs ? jobs->getCurrentThreadIndex() : 0;
+    if (index == 0 || index >= m_streams.size()) {
+        lock.lock();
+        return m_streams[0];
+    }
+    return m_streams[index];
+}
+
+void CommandBuffer::reserveStreams(size_t threadCount) {
+    // Never shrinks: streams may still hold commands recorded for the previous pool.
+    if (threadCount > m_streams.size()) {
+        m_streams.resize(threadCount);
+    }
+}
+
+std::vector<CommandBuffer::Stream*> CommandBuffer::reserveChunkStreams(size_t count) {
+    std::lock_guard<std::mutex> lock(m_chunkStreamMutex);
+    std::vector<Stream*> streams;
+    streams.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (m_chunkStreamCount == m_chunkStreams.size()) {
+            m_chunkStreams.emplace_back();
+        }
+        streams.push_back(&m_chunkStreams[m_chunkStreamCount++]);
+    }
+    return streams;
+}
+
+EntityID CommandBuffer::create() {
+    return m_world.reserveEntity();
+}
+
+void CommandBuffer::destroy(EntityID entityID) {
+    std::unique_lock<std::mutex> lock(m_sharedStreamMutex, std::defer_lock);
+    lockStream(lock).commands.push_back(Command{ CommandType::Destroy, entityID, nullptr, nullptr, nullptr });
+}
+
+bool CommandBuffer::empty() const {
+    for (const Stream& stream : m_streams) {
+        if (!stream.commands.empty()) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < m_chunkStreamCount; i++) {
+        if (!m_chunkStreams[i].commands.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CommandBuffer::playback() {
+    m_world.flushReservedEntities();
+    if (empty()) {
+        return;
+    }
+
+    // Streams are concatenated in thread order, then stably sorted by entity: every entity's commands end
+    // up adjacent and keep their recording order, and the pass walks entity records roughly in memory order.
+    std::vector<const Command*> commands;
+    for (const Stream& stream : m_streams) {
+        for (const Command& command : stream.commands) {
+            commands.push_back(&command);
+        }
+    }
+    for (size_t i = 0; i < m_chunkStreamCount; i++) {
+        for (const Command& command : m_chunkStreams[i].commands) {
+            commands.push_back(&command);
+        }
+    }
+    std::stable_sort(commands.begin(), commands.end(), [](const Command* a, const Command* b) {
+        EntityIndex indexA = getEntityIndex(a->entityID);
+        EntityIndex indexB = getEntityIndex(b->entityID);
+        return indexA != indexB ? indexA < indexB : a->entityID < b->entityID;
+    });
+
+    std::vector<EntityID> destroyed;
+    for (size_t begin = 0; begin < commands.size();) {
+        EntityID entityID = commands[begin]->entityID;
+        size_t end = begin;
+        bool destroy = false;
+        while (end < commands.size() && commands[end]->entityID == entityID) {
+            destroy |= commands[end]->type == CommandType::Destroy;
+            end++;
+        }
+
+        // An entity that is destroyed anyway skips its component changes; the destroys are batched below.
+        if (destroy) {
+            destroyed.push_back(entityID);
+        }
+        else if (m_world.isValidEntity(entityID)) {
+            for (size_t i = begin; i < end; i++) {
+                commands[i]->apply(m_world, entityID, commands[i]->payload);
+            }
+        }
+        begin = end;
+    }
+    m_world.destroyEntities(destroyed);
+
+    clear();
+}
+
+void CommandBuffer::clear() {
+    for (Stream& stream : m_streams) {
+        clearStream(stream);
+    }
+    for (size_t i = 0; i < m_chunkStreamCount; i++) {
+        clearStream(m_chunkStreams[i]);
+    }
+    m_chunkStreamCount = 0;
+}
+
+void CommandBuffer::clearStream(Stream& stream) {
+    for (const Command& command : stream.commands) {
+        if (command.payload && !command.payloadInfo->trivial) {
+            command.payloadInfo->destroy(command.payload);
+        }
+    }
+    stream.commands.clear();
+    stream.largeBlocks.clear();
+    stream.blockCount = 0;
+    stream.blockUsed = 0;
+}
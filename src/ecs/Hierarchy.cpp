@@ -0,0 +1,78 @@
+#include "ecs/Hierarchy.h"
+#include "ecs/World.h"
+
+
+void Hierarchy::detachFromParent(World& world, EntityID child) {
+    const Parent* parent = world.getComponent<const Parent>(child);
+    if (!parent) {
+        return;
+    }
+    if (Children* siblings = world.getComponent<Children>(parent->entity)) {
+        auto& entities = siblings->entities;
+        entities.erase(std::remove(entities.begin(), entities.end(), child), entities.end());
+    }
+}
+
+bool Hierarchy::setParent(World& world, EntityID child, EntityID parent) {
+    if (!world.isValidEntity(child) || !world.isValidEntity(parent)) {
+        LOG_ERROR("Hierarchy::setParent: Invalid entity (child {}, parent {}).", child, parent);
+        return false;
+    }
+    for (EntityID ancestor = parent; ancestor != NULL_ENTITY_ID; ancestor = getParent(world, ancestor)) {
+        if (ancestor == child) {
+            LOG_ERROR("Hierarchy::setParent: Attaching entity {} to {} would create a cycle.", child, parent);
+            return false;
+        }
+    }
+
+    detachFromParent(world, child);
+    if (Parent* link = world.getComponent<Parent>(child)) {
+        link->entity = parent;
+    }
+    else {
+        world.addComponent<Parent>(child, parent);
+    }
+
+    Children* children = world.getComponent<Children>(parent);
+    if (!children) {
+        children = &world.addComponent<Children>(parent);
+    }
+    children->entities.push_back(child);
+    return true;
+}
+
+void Hierarchy::removeParent(World& world, EntityID child) {
+    if (!world.hasComponent<Parent>(child)) {
+        return;
+    }
+    detachFromParent(world, child);
+    world.removeComponent<Parent>(child);
+}
+
+EntityID Hierarchy::getParent(const World& world, EntityID entityID) {
+    const Parent* parent = world.getComponent<Parent>(entityID);
+    return parent && world.isValidEntity(parent->entity) ? parent->entity : NULL_ENTITY_ID;
+}
+
+void Hierarchy::destroyRecursive(World& world, EntityID entityID) {
+    if (!world.isValidEntity(entityID)) {
+        return;
+    }
+    detachFromParent(world, entityID);
+
+    // Breadth-first collection; every descendant is destroyed in a single batch.
+    std::vector<EntityID> subtree{ entityID };
+    for (size_t i = 0; i < subtree.size(); i++) {
+        if (const Children* children = world.getComponent<const Children>(subtree[i])) {
+            subtree.insert(subtree.end(), children->entities.begin(), children->entities.end());
+        }
+    }
+    world.destroyEntities(subtree);
+}
+
+void Hierarchy::registerSnapshotComponents() {
+    SnapshotRegistry::registerComponent<Parent>("Parent");
+    SnapshotRegistry::registerComponent<Children>("Children");
+    SnapshotRegistry::registerComponent<LocalTransform>("LocalTransform");
+    SnapshotRegistry::registerComponent<WorldTransform>("WorldTransform");
+}
@@ -0,0 +1,750 @@
+#include "ecs/Snapshot.h"
+#include "ecs/World.h"
+#include "utils/MappedFile.h"
+
+// Snapshot layout, all integers in native byte order:
+//   header      u32 magic, u32 version
+//   types       u32 count, then per type: string name, u32 element size, u8 flags
+//   slots       u32 count, then u32 generation per entity slot
+//   free list   u32 count, then u32 slot index per free slot, bottom of the stack first
+//   archetypes  u32 count, then per archetype: u32 type count, u32 type indices, u32 row count,
+//               EntityID per row, then per non-tag type: u64 byte size + column block
+//   sparse sets u32 count, then per pool: u32 type index, u64 byte size + pool block
+// Every block carries its size, so types unknown to the loading program are skipped.
+constexpr std::uint32_t SNAPSHOT_MAGIC = 0x504E5357; // "WSNP"
+constexpr std::uint32_t SNAPSHOT_VERSION = 2;
+
+// Deltas share the header and type table, then continue with:
+//   slots       u32 slot count of the source World
+//   structural  u32 count, then per entity: EntityID, u8 alive; live entities add u32 type count,
+//               u32 type indices and one value per type
+//   free list   only if the structural count is non-zero; as in a snapshot
+//   values      u32 count, then per component type: u32 type index, u32 entity count, then per
+//               entity: EntityID and one value
+// A value is a u32 byte size followed by the encoded component, so unknown types can be skipped.
+constexpr std::uint32_t DELTA_MAGIC = 0x544C4457; // "WDLT"
+
+constexpr std::uint8_t SNAPSHOT_TYPE_TAG = 1 << 0;
+constexpr std::uint8_t SNAPSHOT_TYPE_SPARSE = 1 << 1;
+constexpr std::uint8_t SNAPSHOT_TYPE_RAW = 1 << 2;
+
+
+void SnapshotRegistry::add(std::unique_ptr<SnapshotComponentInfo> info) {
+    auto& components = getComponents();
+    auto& names = getNames();
+
+    auto existing = names.find(info->name);
+    if (existing != names.end() && existing->second != info->typeID) {
+        LOG_ERROR("SnapshotRegistry::add: Name '{}' is already registered for another component type.", info->name);
+        return;
+    }
+    if (info->typeID >= components.size()) {
+        components.resize(info->typeID + 1);
+    }
+    if (components[info->typeID]) {
+        names.erase(components[info->typeID]->name);
+    }
+    names[info->name] = info->typeID;
+    components[info->typeID] = std::move(info);
+}
+
+
+void SnapshotRegistry::writeTypeTable(SnapshotWriter& out, const std::vector<const SnapshotComponentInfo*>& types) {
+    out.write(static_cast<std::uint32_t>(types.size()));
+    for (const SnapshotComponentInfo* info : types) {
+        std::uint8_t flags = (info->typeInfo->tag ? SNAPSHOT_TYPE_TAG : 0)
+            | (info->sparse ? SNAPSHOT_TYPE_SPARSE : 0)
+            | (info->raw ? SNAPSHOT_TYPE_RAW : 0);
+        out.writeString(info->name);
+        out.write(static_cast<std::uint32_t>(info->typeInfo->size));
+        out.write(flags);
+    }
+}
+
+std::vector<SnapshotTypeRef> SnapshotRegistry::readTypeTable(SnapshotReader& in) {
+    std::vector<SnapshotTypeRef> types;
+    std::uint32_t typeCount = in.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < typeCount && !in.failed(); i++) {
+        std::string name = in.readString();
+        std::uint32_t size = in.read<std::uint32_t>();
+        std::uint8_t flags = in.read<std::uint8_t>();
+
+        const SnapshotComponentInfo* info = find(name);
+        if (!info) {
+            LOG_WARN("SnapshotRegistry::readTypeTable: Skipping unregistered component '{}'.", name);
+        }
+        else if (info->typeInfo->tag != ((flags & SNAPSHOT_TYPE_TAG) != 0) || info->sparse != ((flags & SNAPSHOT_TYPE_SPARSE) != 0)
+            || info->raw != ((flags & SNAPSHOT_TYPE_RAW) != 0) || (info->raw && info->typeInfo->size != size)) {
+            LOG_ERROR("SnapshotRegistry::readTypeTable: Component '{}' changed layout or storage since it was written; skipping it.", name);
+            info = nullptr;
+        }
+        types.push_back(SnapshotTypeRef{ info, (flags & SNAPSHOT_TYPE_TAG) != 0 });
+    }
+    return types;
+}
+
+
+void World::writeSnapshot(SnapshotWriter& out) const {
+    // Type table: every registered type that occurs in a non-empty archetype or sparse pool.
+    std::vector<const SnapshotComponentInfo*> types;
+    std::array<std::int32_t, ComponentMask::MAX_COMPONENTS> typeIndices;
+    typeIndices.fill(-1);
+    ComponentMask skipped;
+    auto useType = [&](ComponentID typeID) {
+        if (typeIndices[typeID] >= 0 || skipped.test(typeID)) {
+            return;
+        }
+        if (const SnapshotComponentInfo* info = SnapshotRegistry::find(typeID)) {
+            typeIndices[typeID] = static_cast<std::int32_t>(types.size());
+            types.push_back(info);
+        }
+        else {
+            skipped.set(typeID);
+        }
+    };
+
+    for (const Archetype* archetype : m_archetypeList) {
+        if (archetype->empty()) {
+            continue;
+        }
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            if (archetype->getMask().test(typeID)) {
+                useType(typeID);
+            }
+        }
+    }
+    for (ComponentID typeID = 0; typeID < m_sparseSets.size(); typeID++) {
+        if (m_sparseSets[typeID] && !m_sparseSets[typeID]->empty()) {
+            useType(typeID);
+        }
+    }
+    if (!skipped.empty()) {
+        LOG_WARN("World::writeSnapshot: Components without a SnapshotRegistry entry are not saved.");
+    }
+
+    out.write(SNAPSHOT_MAGIC);
+    out.write(SNAPSHOT_VERSION);
+
+    SnapshotRegistry::writeTypeTable(out, types);
+
+    out.write(static_cast<std::uint32_t>(m_entityRecords.size()));
+    for (const EntityRecord& record : m_entityRecords) {
+        out.write(record.generation);
+    }
+    // The free list is saved in order so the restored World hands out the same handles next.
+    out.writeVector(m_freeIndices);
+
+    size_t archetypeCountOffset = out.reserve<std::uint32_t>();
+    std::uint32_t archetypeCount = 0;
+    for (const Archetype* archetype : m_archetypeList) {
+        if (archetype->empty()) {
+            continue;
+        }
+        archetypeCount++;
+
+        std::vector<const SnapshotComponentInfo*> columns;
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            if (archetype->getMask().test(typeID) && typeIndices[typeID] >= 0) {
+                columns.push_back(types[typeIndices[typeID]]);
+            }
+        }
+        out.write(static_cast<std::uint32_t>(columns.size()));
+        for (const SnapshotComponentInfo* info : columns) {
+            out.write(static_cast<std::uint32_t>(typeIndices[info->typeID]));
+        }
+
+        size_t rows = archetype->size();
+        out.write(static_cast<std::uint32_t>(rows));
+        out.writeBytes(archetype->getEntities().data(), rows * sizeof(EntityID));
+
+        for (const SnapshotComponentInfo* info : columns) {
+            if (info->typeInfo->tag) {
+                continue;
+            }
+            const ComponentColumn* column = archetype->getColumn(info->typeID);
+            if (info->raw) {
+                out.write(static_cast<std::uint64_t>(rows * info->typeInfo->size));
+                out.writeBytes(column->get(0), rows * info->typeInfo->size);
+            }
+            else {
+                size_t sizeOffset = out.reserve<std::uint64_t>();
+                size_t begin = out.size();
+                info->writeElements(out, column->get(0), rows);
+                out.patch(sizeOffset, static_cast<std::uint64_t>(out.size() - begin));
+            }
+        }
+    }
+    out.patch(archetypeCountOffset, archetypeCount);
+
+    size_t poolCountOffset = out.reserve<std::uint32_t>();
+    std::uint32_t poolCount = 0;
+    for (const SnapshotComponentInfo* info : types) {
+        if (!info->sparse) {
+            continue;
+        }
+        poolCount++;
+        out.write(static_cast<std::uint32_t>(typeIndices[info->typeID]));
+        size_t sizeOffset = out.reserve<std::uint64_t>();
+        size_t begin = out.size();
+        info->writeSparse(*this, out);
+        out.patch(sizeOffset, static_cast<std::uint64_t>(out.size() - begin));
+    }
+    out.patch(poolCountOffset, poolCount);
+}
+
+bool World::readSnapshot(SnapshotReader& in) {
+    checkStructuralChange("readSnapshot");
+    flushReservedEntities();
+
+    if (in.read<std::uint32_t>() != SNAPSHOT_MAGIC || in.read<std::uint32_t>() != SNAPSHOT_VERSION) {
+        LOG_ERROR("World::readSnapshot: Not a snapshot, or written by an incompatible version.");
+        return false;
+    }
+
+    // Everything up to the slot table is validated before the World is touched.
+    std::vector<SnapshotTypeRef> types = SnapshotRegistry::readTypeTable(in);
+
+    std::uint32_t slotCount = in.read<std::uint32_t>();
+    if (in.failed() || slotCount == 0 || slotCount > in.remaining() / sizeof(EntityGeneration)) {
+        LOG_ERROR("World::readSnapshot: Snapshot is truncated or corrupt.");
+        return false;
+    }
+
+    clearEntities();
+    m_entityRecords.assign(slotCount, EntityRecord{});
+    for (EntityRecord& record : m_entityRecords) {
+        record.generation = in.read<EntityGeneration>();
+    }
+    std::vector<EntityIndex> freeIndices;
+    in.readVector(freeIndices);
+
+    const Tick tick = getChangeTick();
+    bool valid = true;
+    std::uint32_t archetypeCount = in.read<std::uint32_t>();
+    for (std::uint32_t a = 0; a < archetypeCount && valid; a++) {
+        std::vector<std::uint32_t> columns;
+        valid = in.readVector(columns);
+
+        // Tables are keyed by the registered table types only; sparse and unknown types drop out.
+        Archetype* archetype = m_emptyArchetype;
+        for (std::uint32_t typeIndex : columns) {
+            if (typeIndex >= types.size()) {
+                valid = false;
+                break;
+            }
+            const SnapshotComponentInfo* info = types[typeIndex].info;
+            if (info && !info->sparse && !archetype->getMask().test(info->typeID)) {
+                archetype = getAddTransition(*archetype, info->typeID, *info->typeInfo);
+            }
+        }
+
+        std::uint32_t rows = in.read<std::uint32_t>();
+        if (!valid || in.failed() || rows > in.remaining() / sizeof(EntityID)) {
+            valid = false;
+            break;
+        }
+
+        size_t firstRow = archetype->size();
+        EntityID* entities = archetype->appendRows(rows);
+        in.readBytes(entities, rows * sizeof(EntityID));
+        for (std::uint32_t row = 0; row < rows && valid; row++) {
+            EntityIndex index = getEntityIndex(entities[row]);
+            EntityRecord* record = index > 0 && index < slotCount ? &m_entityRecords[index] : nullptr;
+            if (!record || record->archetype || record->generation != getEntityGeneration(entities[row])) {
+                valid = false;
+                break;
+            }
+            record->archetype = archetype;
+            record->row = static_cast<std::uint32_t>(firstRow + row);
+            record->structureTick = tick;
+        }
+
+        for (std::uint32_t typeIndex : columns) {
+            if (!valid || types[typeIndex].tag) {
+                continue;
+            }
+            std::uint64_t byteSize = in.read<std::uint64_t>();
+            const std::byte* block = in.readBlock(static_cast<size_t>(byteSize));
+            const SnapshotComponentInfo* info = types[typeIndex].info;
+            if (!block) {
+                valid = false;
+            }
+            else if (info && !info->sparse) {
+                ComponentColumn* column = archetype->getColumn(info->typeID);
+                if (info->raw) {
+                    if (byteSize != static_cast<std::uint64_t>(rows) * info->typeInfo->size) {
+                        valid = false;
+                        continue;
+                    }
+                    std::memcpy(column->appendUninitialized(rows, tick), block, static_cast<size_t>(byteSize));
+                }
+                else {
+                    SnapshotReader elements(block, static_cast<size_t>(byteSize));
+                    info->readElements(elements, column->appendUninitialized(rows, tick), rows);
+                    valid = !elements.failed();
+                }
+            }
+        }
+    }
+
+    std::uint32_t poolCount = valid ? in.read<std::uint32_t>() : 0;
+    for (std::uint32_t p = 0; p < poolCount && valid; p++) {
+        std::uint32_t typeIndex = in.read<std::uint32_t>();
+        std::uint64_t byteSize = in.read<std::uint64_t>();
+        const std::byte* block = in.readBlock(static_cast<size_t>(byteSize));
+        if (!block || typeIndex >= types.size()) {
+            valid = false;
+            break;
+        }
+        if (const SnapshotComponentInfo* info = types[typeIndex].info) {
+            SnapshotReader pool(block, static_cast<size_t>(byteSize));
+            info->readSparse(*this, pool);
+            valid = !pool.failed();
+        }
+    }
+
+    valid = restoreFreeIndices(freeIndices) && valid;
+
+    if (!valid || in.failed()) {
+        LOG_ERROR("World::readSnapshot: Snapshot is truncated or corrupt; the World was left empty.");
+        clearEntities();
+        return false;
+    }
+    return true;
+}
+
+bool World::saveSnapshot(const std::filesystem::path& path) const {
+    SnapshotWriter writer;
+    writeSnapshot(writer);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("World::saveSnapshot: Cannot open '{}' for writing.", path.string());
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(writer.getBuffer().data()), static_cast<std::streamsize>(writer.size()));
+    if (!file) {
+        LOG_ERROR("World::saveSnapshot: Writing '{}' failed.", path.string());
+        return false;
+    }
+    return true;
+}
+
+bool World::loadSnapshot(const std::filesystem::path& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    SnapshotReader reader(file.data(), file.size());
+    return readSnapshot(reader);
+}
+
+WorldSnapshot World::captureSnapshot() {
+    // Serialising reads every column, so it cannot overlap systems that write them.
+    checkStructuralChange("captureSnapshot");
+    WorldSnapshot snapshot;
+    SnapshotWriter writer;
+    writeSnapshot(writer);
+    snapshot.data = writer.release();
+    snapshot.tick = advanceCaptureTick();
+    return snapshot;
+}
+
+Tick World::advanceCaptureTick() {
+    Tick tick = m_changeTick.fetch_add(1, std::memory_order_relaxed);
+    // Inside a system, writes are stamped with the system's start tick, which is not newer than the
+    // tick just taken. Placing the captured state just before the system keeps its later writes in the
+    // next delta; that delta then also repeats the system's earlier writes, which is harmless because
+    // values are sent whole.
+    return t_currentSystem ? std::min(tick, t_currentSystem->tick - 1) : tick;
+}
+
+bool World::restoreSnapshot(const WorldSnapshot& snapshot) {
+    SnapshotReader reader(snapshot.data.data(), snapshot.data.size());
+    return readSnapshot(reader);
+}
+
+void World::writeDeltaValue(SnapshotWriter& out, const SnapshotComponentInfo& info, const EntityRecord& record, EntityID entityID) const {
+    size_t sizeOffset = out.reserve<std::uint32_t>();
+    size_t begin = out.size();
+    if (info.sparse) {
+        info.writeSparseValue(*this, out, entityID);
+    }
+    else if (!info.typeInfo->tag) {
+        info.writeElements(out, record.archetype->getColumn(info.typeID)->get(record.row), 1);
+    }
+    out.patch(sizeOffset, static_cast<std::uint32_t>(out.size() - begin));
+}
+
+WorldDelta World::diff(Tick since) {
+    checkStructuralChange("diff");
+    flushReservedEntities();
+
+    WorldDelta delta;
+    delta.since = since;
+    delta.until = advanceCaptureTick();
+
+    std::vector<const SnapshotComponentInfo*> types;
+    std::array<std::int32_t, ComponentMask::MAX_COMPONENTS> typeIndices;
+    typeIndices.fill(-1);
+    auto indexOf = [&](ComponentID typeID) {
+        if (typeIndices[typeID] == -1) {
+            const SnapshotComponentInfo* info = SnapshotRegistry::find(typeID);
+            typeIndices[typeID] = info ? static_cast<std::int32_t>(types.size()) : -2;
+            if (info) {
+                types.push_back(info);
+            }
+        }
+        return typeIndices[typeID];
+    };
+
+    SnapshotWriter body;
+    body.write(static_cast<std::uint32_t>(m_entityRecords.size()));
+
+    // Entities created, destroyed or restructured since `since` are sent whole.
+    size_t structuralOffset = body.reserve<std::uint32_t>();
+    std::uint32_t structuralCount = 0;
+    std::vector<std::uint32_t> entityTypes;
+    for (EntityIndex index = 1; index < m_entityRecords.size(); index++) {
+        const EntityRecord& record = m_entityRecords[index];
+        if (record.structureTick <= since) {
+            continue;
+        }
+        structuralCount++;
+        EntityID entityID = makeEntityID(index, record.generation);
+        body.write(entityID);
+        body.write(static_cast<std::uint8_t>(record.archetype != nullptr));
+        if (!record.archetype) {
+            continue;
+        }
+
+        entityTypes.clear();
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            if ((record.archetype->getMask().test(typeID) || record.sparseMask.test(typeID)) && indexOf(typeID) >= 0) {
+                entityTypes.push_back(static_cast<std::uint32_t>(typeIndices[typeID]));
+            }
+        }
+        body.writeVector(entityTypes);
+        for (std::uint32_t typeIndex : entityTypes) {
+            writeDeltaValue(body, *types[typeIndex], record, entityID);
+        }
+    }
+    body.patch(structuralOffset, structuralCount);
+    if (structuralCount > 0) {
+        body.writeVector(m_freeIndices);
+    }
+
+    // Everything else only contributes the values whose row tick is newer than `since`. Columns and
+    // pools whose newest tick is older are skipped without looking at their rows.
+    size_t groupOffset = body.reserve<std::uint32_t>();
+    std::uint32_t groupCount = 0;
+    auto writeGroup = [&](const SnapshotComponentInfo& info, const ComponentTicks* ticks, const EntityID* entities, size_t count) {
+        size_t countOffset = 0;
+        std::uint32_t written = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (ticks[i].changed <= since) {
+                continue;
+            }
+            const EntityRecord& record = m_entityRecords[getEntityIndex(entities[i])];
+            if (record.structureTick > since) {
+                continue;
+            }
+            if (written++ == 0) {
+                body.write(static_cast<std::uint32_t>(indexOf(info.typeID)));
+                countOffset = body.reserve<std::uint32_t>();
+            }
+            body.write(entities[i]);
+            writeDeltaValue(body, info, record, entities[i]);
+        }
+        if (written > 0) {
+            body.patch(countOffset, written);
+            groupCount++;
+        }
+    };
+
+    for (const Archetype* archetype : m_archetypeList) {
+        if (archetype->empty()) {
+            continue;
+        }
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            const ComponentColumn* column = archetype->getMask().test(typeID) ? archetype->getColumn(typeID) : nullptr;
+            const SnapshotComponentInfo* info = column ? SnapshotRegistry::find(typeID) : nullptr;
+            if (info && column->getColumnTicks().changed > since) {
+                writeGroup(*info, column->ticks(), archetype->getEntities().data(), archetype->size());
+            }
+        }
+    }
+    for (ComponentID typeID = 0; typeID < m_sparseSets.size(); typeID++) {
+        const SparseSetBase* pool = m_sparseSets[typeID].get();
+        const SnapshotComponentInfo* info = pool ? SnapshotRegistry::find(typeID) : nullptr;
+        if (info && pool->getPoolTicks().changed > since) {
+            writeGroup(*info, pool->ticks(), pool->getEntities().data(), pool->size());
+        }
+    }
+    body.patch(groupOffset, groupCount);
+
+    SnapshotWriter out;
+    out.write(DELTA_MAGIC);
+    out.write(SNAPSHOT_VERSION);
+    SnapshotRegistry::writeTypeTable(out, types);
+    out.writeBytes(body.getBuffer().data(), body.size());
+    delta.data = out.release();
+    return delta;
+}
+
+WorldDelta World::diff(const WorldSnapshot& from, const WorldSnapshot& to) {
+    // Both states are loaded into scratch Worlds. Every tick of `to` is cleared, then the slots and
+    // values that differ from `from` are stamped with tick 1, so the tick-based diff picks up exactly
+    // those. The scratch Worlds belong to no system, so a caller's system must not apply to them.
+    const SystemNode* outerSystem = t_currentSystem;
+    t_currentSystem = nullptr;
+    World base;
+    World target;
+    if (!base.restoreSnapshot(from) || !target.restoreSnapshot(to)) {
+        t_currentSystem = outerSystem;
+        LOG_ERROR("World::diff: A snapshot could not be loaded; returning an empty delta.");
+        return WorldDelta{};
+    }
+
+    constexpr Tick UNCHANGED = 0;
+    constexpr Tick CHANGED = 1;
+    for (Archetype* archetype : target.m_archetypeList) {
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            ComponentColumn* column = archetype->getMask().test(typeID) ? archetype->getColumn(typeID) : nullptr;
+            if (!column) {
+                continue;
+            }
+            column->markColumnChanged(UNCHANGED);
+            for (size_t row = 0; row < column->size(); row++) {
+                column->ticks()[row].changed = UNCHANGED;
+            }
+        }
+    }
+    for (auto& pool : target.m_sparseSets) {
+        if (!pool) {
+            continue;
+        }
+        pool->markPoolChanged(UNCHANGED);
+        for (size_t i = 0; i < pool->size(); i++) {
+            pool->ticks()[i].changed = UNCHANGED;
+        }
+    }
+
+    // Slots `to` does not have (it was captured before they were first used) become dead slots there.
+    // They are always sent, which also carries the free list that puts them back in creation order.
+    size_t firstExtra = target.m_entityRecords.size();
+    if (base.m_entityRecords.size() > firstExtra) {
+        target.m_entityRecords.resize(base.m_entityRecords.size());
+        for (size_t index = firstExtra; index < base.m_entityRecords.size(); index++) {
+            const EntityRecord& old = base.m_entityRecords[index];
+            target.m_entityRecords[index].generation = old.generation + (old.archetype ? 1 : 0);
+        }
+        std::vector<EntityIndex> freeIndices = target.m_freeIndices;
+        target.restoreFreeIndices(freeIndices);
+    }
+
+    SnapshotWriter before;
+    SnapshotWriter after;
+    for (EntityIndex index = 1; index < target.m_entityRecords.size(); index++) {
+        EntityRecord& record = target.m_entityRecords[index];
+        const EntityRecord* old = index < base.m_entityRecords.size() ? &base.m_entityRecords[index] : nullptr;
+        bool same = old && old->generation == record.generation && (old->archetype != nullptr) == (record.archetype != nullptr)
+            && (!record.archetype || (old->archetype->getMask() == record.archetype->getMask() && old->sparseMask == record.sparseMask));
+        record.structureTick = same && index < firstExtra ? UNCHANGED : CHANGED;
+        if (!same || !record.archetype) {
+            continue;
+        }
+
+        EntityID entityID = makeEntityID(index, record.generation);
+        for (ComponentID typeID = 0; typeID < ComponentMask::MAX_COMPONENTS; typeID++) {
+            bool table = record.archetype->getMask().test(typeID);
+            const SnapshotComponentInfo* info = table || record.sparseMask.test(typeID) ? SnapshotRegistry::find(typeID) : nullptr;
+            if (!info || info->typeInfo->tag) {
+                continue;
+            }
+            before = SnapshotWriter{};
+            after = SnapshotWriter{};
+            base.writeDeltaValue(before, *info, *old, entityID);
+            target.writeDeltaValue(after, *info, record, entityID);
+            if (before.getBuffer() == after.getBuffer()) {
+                continue;
+            }
+            if (table) {
+                ComponentColumn* column = record.archetype->getColumn(typeID);
+                column->ticks()[record.row].changed = CHANGED;
+                column->markColumnChanged(CHANGED);
+            }
+            else {
+                SparseSetBase* pool = target.m_sparseSets[typeID].get();
+                pool->ticks()[pool->indexOf(entityID)].changed = CHANGED;
+                pool->markPoolChanged(CHANGED);
+            }
+        }
+    }
+
+    WorldDelta delta = target.diff(UNCHANGED);
+    delta.since = from.tick;
+    delta.until = to.tick;
+    t_currentSystem = outerSystem;
+    return delta;
+}
+
+bool World::applyStructuralDelta(SnapshotReader& in, const std::vector<SnapshotTypeRef>& types, Tick tick) {
+    EntityID entityID = in.read<EntityID>();
+    bool alive = in.read<std::uint8_t>() != 0;
+    EntityIndex index = getEntityIndex(entityID);
+    if (in.failed() || index == 0 || index >= m_entityRecords.size()) {
+        return false;
+    }
+
+    // The whole entry is read and validated before the slot is touched.
+    struct Value {
+        const SnapshotComponentInfo* info;
+        const std::byte* data;
+        std::uint32_t size;
+    };
+    std::vector<Value> values;
+    std::vector<std::uint32_t> typeIndices;
+    if (alive && !in.readVector(typeIndices)) {
+        return false;
+    }
+    for (std::uint32_t typeIndex : typeIndices) {
+        std::uint32_t size = in.read<std::uint32_t>();
+        const std::byte* data = in.readBlock(size);
+        if (!data || typeIndex >= types.size()) {
+            return false;
+        }
+        const SnapshotComponentInfo* info = types[typeIndex].info;
+        if (!info) {
+            continue;
+        }
+        if (info->raw && !info->typeInfo->tag && size != info->typeInfo->size) {
+            return false;
+        }
+        values.push_back(Value{ info, data, size });
+    }
+
+    // The free list is rebuilt by applyDelta once all structural entries are in. Until then the released
+    // slot is kept off it, so the reservation cursor stays in sync and no flush can claim the slot.
+    EntityRecord& record = m_entityRecords[index];
+    if (record.archetype) {
+        releaseEntity(record, makeEntityID(index, record.generation));
+        m_freeIndices.pop_back();
+    }
+    record.generation = getEntityGeneration(entityID);
+    record.structureTick = tick;
+    if (!alive) {
+        return true;
+    }
+
+    Archetype* archetype = m_emptyArchetype;
+    for (const Value& value : values) {
+        if (!value.info->sparse && !archetype->getMask().test(value.info->typeID)) {
+            archetype = getAddTransition(*archetype, value.info->typeID, *value.info->typeInfo);
+        }
+    }
+    record.archetype = archetype;
+    record.row = static_cast<std::uint32_t>(archetype->pushEntity(entityID));
+
+    for (const Value& value : values) {
+        SnapshotReader reader(value.data, value.size);
+        if (value.info->sparse) {
+            value.info->readSparseValue(*this, reader, entityID);
+            continue;
+        }
+        ComponentColumn* column = archetype->getColumn(value.info->typeID);
+        // Tags have no column; a repeated type finds its column already filled.
+        if (!column || column->size() != record.row) {
+            continue;
+        }
+        void* dst = column->appendUninitialized(1, tick);
+        if (value.info->raw) {
+            std::memcpy(dst, value.data, value.size);
+        }
+        else {
+            value.info->readElements(reader, dst, 1);
+        }
+    }
+    return true;
+}
+
+bool World::applyDelta(const WorldDelta& delta) {
+    checkStructuralChange("applyDelta");
+    flushReservedEntities();
+
+    SnapshotReader in(delta.data.data(), delta.data.size());
+    if (in.read<std::uint32_t>() != DELTA_MAGIC || in.read<std::uint32_t>() != SNAPSHOT_VERSION) {
+        LOG_ERROR("World::applyDelta: Not a delta, or written by an incompatible version.");
+        return false;
+    }
+    std::vector<SnapshotTypeRef> types = SnapshotRegistry::readTypeTable(in);
+    std::uint32_t slotCount = in.read<std::uint32_t>();
+    if (in.failed()) {
+        LOG_ERROR("World::applyDelta: Delta is truncated or corrupt.");
+        return false;
+    }
+    bool grown = slotCount > m_entityRecords.size();
+    if (grown) {
+        m_entityRecords.resize(slotCount);
+    }
+
+    const Tick tick = getChangeTick();
+    bool valid = true;
+    std::uint32_t structuralCount = in.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < structuralCount && valid; i++) {
+        valid = applyStructuralDelta(in, types, tick);
+    }
+    if (structuralCount > 0) {
+        std::vector<EntityIndex> freeIndices;
+        valid = valid && in.readVector(freeIndices) && restoreFreeIndices(freeIndices);
+    }
+    else if (grown) {
+        // The new slots are free; they go beneath the existing free list.
+        std::vector<EntityIndex> freeIndices = m_freeIndices;
+        restoreFreeIndices(freeIndices);
+    }
+
+    std::uint32_t groupCount = valid ? in.read<std::uint32_t>() : 0;
+    for (std::uint32_t group = 0; group < groupCount && valid; group++) {
+        std::uint32_t typeIndex = in.read<std::uint32_t>();
+        std::uint32_t count = in.read<std::uint32_t>();
+        if (in.failed() || typeIndex >= types.size()) {
+            valid = false;
+            break;
+        }
+        const SnapshotComponentInfo* info = types[typeIndex].info;
+        for (std::uint32_t i = 0; i < count; i++) {
+            EntityID entityID = in.read<EntityID>();
+            std::uint32_t size = in.read<std::uint32_t>();
+            const std::byte* data = in.readBlock(size);
+            EntityRecord* record = data ? findRecord(entityID) : nullptr;
+            if (!data || (info && info->raw && size != info->typeInfo->size)) {
+                valid = false;
+                break;
+            }
+            if (!info || !record) {
+                continue;
+            }
+
+            SnapshotReader reader(data, size);
+            if (info->sparse) {
+                info->readSparseValue(*this, reader, entityID);
+            }
+            else if (ComponentColumn* column = record->archetype->getColumn(info->typeID)) {
+                if (info->raw) {
+                    std::memcpy(column->get(record->row), data, size);
+                }
+                else {
+                    info->assignElement(reader, column->get(record->row));
+                }
+                column->markChanged(record->row, tick);
+            }
+        }
+    }
+
+    if (!valid || in.failed()) {
+        LOG_ERROR("World::applyDelta: Delta is truncated or corrupt; it was only partly applied.");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#include "ecs/SparseSet.h"
+
+
+std::uint32_t SparseSetBase::insertEntity(EntityID entityID) {
+    EntityIndex entityIndex = getEntityIndex(entityID);
+    size_t page = entityIndex / PAGE_SIZE;
+    if (page >= m_sparse.size()) {
+        m_sparse.resize(page + 1);
+    }
+    if (!m_sparse[page]) {
+        m_sparse[page] = std::make_unique<std::uint32_t[]>(PAGE_SIZE);
+        std::fill_n(m_sparse[page].get(), PAGE_SIZE, INVALID_INDEX);
+    }
+
+    std::uint32_t index = static_cast<std::uint32_t>(m_dense.size());
+    m_sparse[page][entityIndex % PAGE_SIZE] = index;
+    m_dense.push_back(entityID);
+    m_ticks.emplace_back();
+    return index;
+}
+
+void SparseSetBase::remove(EntityID entityID) {
+    std::uint32_t index = indexOf(entityID);
+    if (index == INVALID_INDEX) {
+        return;
+    }
+
+    EntityIndex last = getEntityIndex(m_dense.back());
+    EntityIndex removed = getEntityIndex(entityID);
+    m_dense[index] = m_dense.back();
+    m_ticks[index] = m_ticks.back();
+    m_ticks.pop_back();
+    m_sparse[last / PAGE_SIZE][last % PAGE_SIZE] = index;
+    m_dense.pop_back();
+    m_sparse[removed / PAGE_SIZE][removed % PAGE_SIZE] = INVALID_INDEX;
+
+    swapAndPopData(index);
+}
+
+void SparseSetBase::clear() {
+    m_sparse.clear();
+    m_dense.clear();
+    m_ticks.clear();
+    clearData();
+}
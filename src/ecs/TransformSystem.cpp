@@ -0,0 +1,214 @@
+#include "ecs/TransformSystem.h"
+#include "ecs/World.h"
+
+
+void TransformSystem::onAddedToWorld(World& world) {
+    m_transforms = &world.query<const LocalTransform, const WorldTransform>();
+    m_parents = &world.query<const Parent>();
+    m_children = &world.query<const Children>();
+}
+
+void TransformSystem::update(float deltaTime [[maybe_unused]], World& world) {
+    Tick since = getLastRunTick();
+    bool full = since == 0 || m_stale.exchange(false, std::memory_order_relaxed);
+    bool rebuilt = full || collectMovedEntities(world, since);
+    if (rebuilt) {
+        rebuild(world);
+    }
+    if (full) {
+        for (std::uint32_t root = 0; root + 1 < m_rootOffsets.size(); root++) {
+            m_dirtyRoots.push_back(root);
+        }
+    }
+    else {
+        collectDirtyRoots(since, rebuilt);
+    }
+    if (m_dirtyRoots.empty()) {
+        return;
+    }
+
+    size_t dirtyEntries = 0;
+    for (std::uint32_t root : m_dirtyRoots) {
+        dirtyEntries += m_rootOffsets[root + 1] - m_rootOffsets[root];
+    }
+
+    const World& view = world;
+    if (dirtyEntries < PARALLEL_THRESHOLD) {
+        for (std::uint32_t root : m_dirtyRoots) {
+            propagate(view, root, since, rebuilt);
+        }
+    }
+    else {
+        // Roots are grouped so a job covers about PARALLEL_CHUNK_ENTRIES entries on average.
+        size_t grainSize = std::max<size_t>(m_dirtyRoots.size() * PARALLEL_CHUNK_ENTRIES / dirtyEntries, 1);
+        world.parallelFor(m_dirtyRoots.size(), grainSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                propagate(view, m_dirtyRoots[i], since, rebuilt);
+            }
+        });
+    }
+
+    // Only the write-back stamps WorldTransform, and only for entries that were recomputed.
+    for (std::uint32_t root : m_dirtyRoots) {
+        for (size_t i = m_rootOffsets[root]; i < m_rootOffsets[root + 1]; i++) {
+            if (!m_dirty[i]) {
+                continue;
+            }
+            if (WorldTransform* transform = world.getComponent<WorldTransform>(m_entries[i].entity)) {
+                transform->matrix = m_worldMatrices[i];
+            }
+        }
+    }
+}
+
+bool TransformSystem::hasTransforms(const World& world, EntityID entityID) {
+    return world.hasComponent<LocalTransform>(entityID) && world.hasComponent<WorldTransform>(entityID);
+}
+
+bool TransformSystem::collectMovedEntities(const World& world, Tick since) {
+    m_movedEntities.clear();
+    auto moved = [this](EntityID entityID, const auto&...) { m_movedEntities.push_back(entityID); };
+
+    m_parents->forEach(Changed<Parent>{ since }, moved);
+    m_transforms->forEach(Added<LocalTransform>{ since }, moved);
+    m_transforms->forEach(Added<WorldTransform>{ since }, moved);
+    // Hierarchy edits always touch a Children component. A detached child loses its Parent without a
+    // tick of its own, so every child the entity had in the current layout counts as moved as well.
+    m_children->forEach(Changed<Children>{ since }, [this](EntityID entityID, const Children&) {
+        m_movedEntities.push_back(entityID);
+        EntityIndex index = getEntityIndex(entityID);
+        std::uint32_t entry = index < m_entityEntries.size() ? m_entityEntries[index] : INVALID_ENTRY;
+        if (entry == INVALID_ENTRY || m_entries[entry].entity != entityID) {
+            return;
+        }
+        for (size_t i = entry + 1; i < m_rootOffsets[m_entries[entry].root + 1]; i++) {
+            if (m_entries[i].parent == static_cast<std::int32_t>(entry)) {
+                m_movedEntities.push_back(m_entries[i].entity);
+            }
+        }
+    });
+    bool changed = !m_movedEntities.empty();
+
+    // Destroying an entity or removing its transforms leaves no tick either. After any removal, entries
+    // that are gone force a rebuild and their children, which become roots, count as moved.
+    if (world.getRemovalTick() > since) {
+        m_lost.resize(m_entries.size());
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            const Entry& entry = m_entries[i];
+            m_lost[i] = !hasTransforms(world, entry.entity);
+            changed |= m_lost[i] != 0;
+            if (entry.parent >= 0 && m_lost[entry.parent] && !m_lost[i]) {
+                m_movedEntities.push_back(entry.entity);
+            }
+        }
+    }
+    return changed;
+}
+
+void TransformSystem::collectDirtyRoots(Tick since, bool rebuilt) {
+    for (std::uint32_t root : m_dirtyRoots) {
+        m_rootQueued[root] = 0;
+    }
+    m_dirtyRoots.clear();
+
+    m_transforms->forEach(Changed<LocalTransform>{ since }, [this](EntityID entityID, const auto&...) {
+        queueRoot(entityID);
+    });
+    if (rebuilt) {
+        for (EntityID entityID : m_movedEntities) {
+            queueRoot(entityID);
+        }
+    }
+    // Walk the subtrees in layout order.
+    std::sort(m_dirtyRoots.begin(), m_dirtyRoots.end());
+}
+
+void TransformSystem::queueRoot(EntityID entityID) {
+    EntityIndex index = getEntityIndex(entityID);
+    std::uint32_t entry = index < m_entityEntries.size() ? m_entityEntries[index] : INVALID_ENTRY;
+    if (entry == INVALID_ENTRY || m_entries[entry].entity != entityID) {
+        return;
+    }
+    std::uint32_t root = m_entries[entry].root;
+    if (!m_rootQueued[root]) {
+        m_rootQueued[root] = 1;
+        m_dirtyRoots.push_back(root);
+    }
+}
+
+void TransformSystem::rebuild(const World& world) {
+    m_previousEntries.swap(m_entries);
+    m_previousMatrices.swap(m_worldMatrices);
+    m_entries.clear();
+    m_rootOffsets.clear();
+
+    // An entity is a root if its parent is gone or does not take part in propagation itself.
+    m_transforms->forEach([&](EntityID entityID, const LocalTransform&, const WorldTransform&) {
+        EntityID parent = Hierarchy::getParent(world, entityID);
+        if (parent != NULL_ENTITY_ID && hasTransforms(world, parent)) {
+            return;
+        }
+
+        size_t begin = m_entries.size();
+        std::uint32_t root = static_cast<std::uint32_t>(m_rootOffsets.size());
+        m_rootOffsets.push_back(static_cast<std::uint32_t>(begin));
+        m_entries.push_back(Entry{ entityID, -1, root });
+        for (size_t i = begin; i < m_entries.size(); i++) {
+            const Children* children = world.getComponent<Children>(m_entries[i].entity);
+            if (!children) {
+                continue;
+            }
+            for (EntityID child : children->entities) {
+                if (hasTransforms(world, child)) {
+                    m_entries.push_back(Entry{ child, static_cast<std::int32_t>(i), root });
+                }
+            }
+        }
+    });
+    m_rootOffsets.push_back(static_cast<std::uint32_t>(m_entries.size()));
+
+    // Subtrees that no moved entity marks dirty are not recomputed, so their matrices come along from
+    // the previous layout; later partial runs read them as parents.
+    m_worldMatrices.resize(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        EntityIndex index = getEntityIndex(m_entries[i].entity);
+        std::uint32_t previous = index < m_entityEntries.size() ? m_entityEntries[index] : INVALID_ENTRY;
+        if (previous != INVALID_ENTRY && m_previousEntries[previous].entity == m_entries[i].entity) {
+            m_worldMatrices[i] = m_previousMatrices[previous];
+        }
+    }
+
+    m_entityEntries.assign(m_entityEntries.size(), INVALID_ENTRY);
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        EntityIndex index = getEntityIndex(m_entries[i].entity);
+        if (index >= m_entityEntries.size()) {
+            m_entityEntries.resize(index + 1, INVALID_ENTRY);
+        }
+        m_entityEntries[index] = static_cast<std::uint32_t>(i);
+    }
+    m_dirtyRoots.clear();
+    m_rootQueued.assign(m_rootOffsets.size() - 1, 0);
+    m_dirty.assign(m_entries.size(), 0);
+}
+
+void TransformSystem::propagate(const World& world, std::uint32_t root, Tick since, bool force) {
+    for (size_t i = m_rootOffsets[root]; i < m_rootOffsets[root + 1]; i++) {
+        const Entry& entry = m_entries[i];
+        const ComponentTicks* ticks = world.getComponentTicks<LocalTransform>(entry.entity);
+        if (!ticks) {
+            // Lost its transform or was destroyed without going through Hierarchy; rebuild next run.
+            m_stale.store(true, std::memory_order_relaxed);
+            m_dirty[i] = 0;
+            continue;
+        }
+
+        bool parentDirty = entry.parent >= 0 && m_dirty[entry.parent];
+        m_dirty[i] = force || parentDirty || ticks->changed > since;
+        if (!m_dirty[i]) {
+            continue;
+        }
+
+        glm::mat4 local = world.getComponent<LocalTransform>(entry.entity)->getMatrix();
+        m_worldMatrices[i] = entry.parent >= 0 ? m_worldMatrices[entry.parent] * local : local;
+    }
+}
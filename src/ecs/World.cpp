@@ -1,56 +1,512 @@
 #include "ecs/World.h"
+#include "ecs/CommandBuffer.h"
 
 
+World::World() {
+    m_emptyArchetype = registerArchetype(std::make_unique<Archetype>(ComponentMask{}));
+    // Reserve slot 0 so NULL_ENTITY_ID never refers to a live entity.
+    m_entityRecords.emplace_back();
+    // Created eagerly: concurrently scheduled systems must not race on creating it.
+    m_commandBuffer = std::make_unique<CommandBuffer>(*this);
+}
+
+World::~World() = default;
+
 EntityID World::createEntity() {
-    EntityID entityID = EntityIDAllocator::allocate();
-    m_entities.insert(entityID);
+    checkStructuralChange("createEntity");
+    flushReservedEntities();
+
+    EntityIndex index;
+    if (!m_freeIndices.empty()) {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else {
+        index = static_cast<EntityIndex>(m_entityRecords.size());
+        m_entityRecords.emplace_back();
+    }
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+
+    EntityRecord& record = m_entityRecords[index];
+    EntityID entityID = makeEntityID(index, record.generation);
+    record.archetype = m_emptyArchetype;
+    record.row = static_cast<std::uint32_t>(m_emptyArchetype->pushEntity(entityID));
+    record.structureTick = getChangeTick();
+    m_entityCount++;
     return entityID;
 }
 
+EntityID World::reservedEntityAt(std::int64_t cursor) const {
+    if (cursor >= 0) {
+        EntityIndex index = m_freeIndices[static_cast<size_t>(cursor)];
+        return makeEntityID(index, m_entityRecords[index].generation);
+    }
+    return makeEntityID(static_cast<EntityIndex>(m_entityRecords.size() + static_cast<size_t>(-cursor - 1)), 0);
+}
+
+EntityID World::reserveEntity() {
+    return reservedEntityAt(m_freeCursor.fetch_sub(1, std::memory_order_relaxed) - 1);
+}
+
+void World::reserveEntities(size_t count, std::vector<EntityID>& out) {
+    std::int64_t end = m_freeCursor.fetch_sub(static_cast<std::int64_t>(count), std::memory_order_relaxed);
+    out.reserve(out.size() + count);
+    for (std::int64_t cursor = end - 1; cursor >= end - static_cast<std::int64_t>(count); cursor--) {
+        out.push_back(reservedEntityAt(cursor));
+    }
+}
+
+void World::flushReservedEntities() {
+    if (!hasReservedEntities()) {
+        return;
+    }
+
+    std::int64_t cursor = m_freeCursor.load(std::memory_order_relaxed);
+    size_t freeBegin = static_cast<size_t>(std::max<std::int64_t>(cursor, 0));
+    size_t newCount = cursor < 0 ? static_cast<size_t>(-cursor) : 0;
+
+    const Tick tick = getChangeTick();
+    auto materialize = [this, tick](EntityIndex index) {
+        EntityRecord& record = m_entityRecords[index];
+        record.archetype = m_emptyArchetype;
+        record.structureTick = tick;
+        record.row = static_cast<std::uint32_t>(m_emptyArchetype->pushEntity(makeEntityID(index, record.generation)));
+    };
+
+    m_emptyArchetype->reserve(m_emptyArchetype->size() + (m_freeIndices.size() - freeBegin) + newCount);
+    for (size_t i = freeBegin; i < m_freeIndices.size(); i++) {
+        materialize(m_freeIndices[i]);
+    }
+    size_t firstNew = m_entityRecords.size();
+    m_entityRecords.resize(firstNew + newCount);
+    for (size_t i = 0; i < newCount; i++) {
+        materialize(static_cast<EntityIndex>(firstNew + i));
+    }
+
+    m_entityCount += (m_freeIndices.size() - freeBegin) + newCount;
+    m_freeIndices.resize(freeBegin);
+    m_freeCursor.store(static_cast<std::int64_t>(freeBegin), std::memory_order_relaxed);
+}
+
 void World::destroyEntity(EntityID entityID) {
-    if (m_entities.find(entityID) == m_entities.end()) {
+    checkStructuralChange("destroyEntity");
+    flushReservedEntities();
+
+    EntityRecord* record = findRecord(entityID);
+    if (!record) {
         return;
     }
 
-    auto entityIt = m_components.find(entityID);
-    if (entityIt != m_components.end()) {
-        m_components.erase(entityIt);
+    releaseEntity(*record, entityID);
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+}
+
+void World::destroyEntities(const std::vector<EntityID>& entityIDs) {
+    checkStructuralChange("destroyEntities");
+    flushReservedEntities();
+
+    m_freeIndices.reserve(m_freeIndices.size() + entityIDs.size());
+    for (EntityID entityID : entityIDs) {
+        // Duplicates are harmless: the first release bumps the generation, so later copies no longer match.
+        if (EntityRecord* record = findRecord(entityID)) {
+            releaseEntity(*record, entityID);
+        }
     }
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+}
 
-    m_entityMasks.erase(entityID);
+void World::releaseEntity(EntityRecord& record, EntityID entityID) {
+    EntityID swapped = record.archetype->removeRow(record.row);
+    if (swapped != NULL_ENTITY_ID) {
+        m_entityRecords[getEntityIndex(swapped)].row = record.row;
+    }
 
-    m_entities.erase(entityID);
+    if (!record.sparseMask.empty()) {
+        for (ComponentID typeID = 0; typeID < m_sparseSets.size(); typeID++) {
+            if (m_sparseSets[typeID] && record.sparseMask.test(typeID)) {
+                m_sparseSets[typeID]->remove(entityID);
+            }
+        }
+        record.sparseMask = ComponentMask{};
+    }
 
-    EntityIDAllocator::deallocate(entityID);
+    record.archetype = nullptr;
+    record.row = 0;
+    record.generation++;
+    record.structureTick = getChangeTick();
+    m_removalTick = record.structureTick;
+    m_freeIndices.push_back(getEntityIndex(entityID));
+    m_entityCount--;
+}
+
+void World::clearEntities() {
+    for (Archetype* archetype : m_archetypeList) {
+        archetype->clear();
+    }
+    for (auto& pool : m_sparseSets) {
+        if (pool) {
+            pool->clear();
+        }
+    }
+    // Slots that were already free keep their place in the free list; the released ones go on top.
+    for (EntityIndex index = static_cast<EntityIndex>(m_entityRecords.size()); index-- > 1;) {
+        EntityRecord& record = m_entityRecords[index];
+        if (record.archetype) {
+            record = EntityRecord{ nullptr, 0, record.generation + 1, getChangeTick(), ComponentMask{} };
+            m_freeIndices.push_back(index);
+        }
+    }
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+    m_entityCount = 0;
+    m_removalTick = getChangeTick();
+}
+
+bool World::restoreFreeIndices(const std::vector<EntityIndex>& freeIndices) {
+    std::vector<std::uint8_t> listed(m_entityRecords.size(), 0);
+    bool valid = true;
+    for (EntityIndex index : freeIndices) {
+        if (index == 0 || index >= m_entityRecords.size() || m_entityRecords[index].archetype || listed[index]) {
+            valid = false;
+            break;
+        }
+        listed[index] = 1;
+    }
+
+    m_freeIndices.clear();
+    m_entityCount = 0;
+    for (EntityIndex index = static_cast<EntityIndex>(m_entityRecords.size()); index-- > 1;) {
+        if (m_entityRecords[index].archetype) {
+            m_entityCount++;
+        }
+        else if (!valid || !listed[index]) {
+            m_freeIndices.push_back(index);
+        }
+    }
+    if (valid) {
+        m_freeIndices.insert(m_freeIndices.end(), freeIndices.begin(), freeIndices.end());
+    }
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+    return valid;
+}
+
+void World::allocateIndices(size_t count, std::vector<EntityID>& out) {
+    size_t recycled = std::min(count, m_freeIndices.size());
+    out.reserve(out.size() + count);
+    for (size_t i = 0; i < recycled; i++) {
+        EntityIndex index = m_freeIndices[m_freeIndices.size() - 1 - i];
+        out.push_back(makeEntityID(index, m_entityRecords[index].generation));
+    }
+    m_freeIndices.resize(m_freeIndices.size() - recycled);
+
+    EntityIndex firstNew = static_cast<EntityIndex>(m_entityRecords.size());
+    m_entityRecords.resize(m_entityRecords.size() + (count - recycled));
+    for (size_t i = 0; i < count - recycled; i++) {
+        out.push_back(makeEntityID(static_cast<EntityIndex>(firstNew + i), 0));
+    }
+
+    m_freeCursor.store(static_cast<std::int64_t>(m_freeIndices.size()), std::memory_order_relaxed);
+    m_entityCount += count;
 }
 
 bool World::isValidEntity(EntityID entityID) const {
-    return m_entities.find(entityID) != m_entities.end();
+    return findRecord(entityID) != nullptr;
+}
+
+std::vector<EntityID> World::getAllEntities() const {
+    std::vector<EntityID> entities;
+    entities.reserve(m_entityCount);
+    for (const Archetype* archetype : m_archetypeList) {
+        entities.insert(entities.end(), archetype->getEntities().begin(), archetype->getEntities().end());
+    }
+    return entities;
+}
+
+Archetype* World::findArchetype(const ComponentMask& mask) const {
+    auto it = m_archetypes.find(mask);
+    return it != m_archetypes.end() ? it->second.get() : nullptr;
+}
+
+Archetype* World::registerArchetype(std::unique_ptr<Archetype> archetype) {
+    Archetype* raw = archetype.get();
+    m_archetypes[raw->getMask()] = std::move(archetype);
+    m_archetypeList.push_back(raw);
+    std::lock_guard<std::mutex> lock(m_queryMutex);
+    for (auto& query : m_queries) {
+        if (query) {
+            query->onArchetypeCreated(raw);
+        }
+    }
+    return raw;
+}
+
+Archetype* World::getAddTransition(Archetype& src, ComponentID typeID, const ComponentTypeInfo& info) {
+    if (Archetype* cached = src.getAddEdge(typeID)) {
+        return cached;
+    }
+
+    ComponentMask mask = src.getMask();
+    mask.set(typeID);
+    Archetype* dst = findArchetype(mask);
+    if (!dst) {
+        dst = registerArchetype(src.createWith(typeID, info));
+    }
+
+    src.setAddEdge(typeID, dst);
+    dst->setRemoveEdge(typeID, &src);
+    return dst;
+}
+
+Archetype* World::getRemoveTransition(Archetype& src, ComponentID typeID) {
+    if (Archetype* cached = src.getRemoveEdge(typeID)) {
+        return cached;
+    }
+
+    ComponentMask mask = src.getMask();
+    mask.reset(typeID);
+    Archetype* dst = findArchetype(mask);
+    if (!dst) {
+        dst = registerArchetype(src.createWithout(typeID));
+    }
+
+    src.setRemoveEdge(typeID, dst);
+    dst->setAddEdge(typeID, &src);
+    return dst;
+}
+
+void World::moveEntity(EntityRecord& record, Archetype& dst) {
+    size_t dstRow = dst.size();
+    EntityID swapped = record.archetype->moveRowTo(record.row, dst);
+    if (swapped != NULL_ENTITY_ID) {
+        m_entityRecords[getEntityIndex(swapped)].row = record.row;
+    }
+    record.archetype = &dst;
+    record.row = static_cast<std::uint32_t>(dstRow);
+    record.structureTick = getChangeTick();
+}
+
+CommandBuffer& World::getCommandBuffer() {
+    return *m_commandBuffer;
+}
+
+JobSystem& World::getJobSystem() {
+    if (!m_jobSystem) {
+        setJobSystem(std::make_shared<JobSystem>());
+    }
+    return *m_jobSystem;
+}
+
+void World::setJobSystem(std::shared_ptr<JobSystem> jobSystem) {
+    m_jobSystem = std::move(jobSystem);
+    if (m_jobSystem) {
+        m_commandBuffer->reserveStreams(m_jobSystem->getThreadCount());
+    }
+}
+
+void World::parallelFor(JobSystem& jobs, size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func, bool deterministic) {
+    const SystemNode* system = t_currentSystem;
+    std::mutex stampMutex;
+    ChunkStamps stamps;
+    const size_t chunkSize = std::max<size_t>(grainSize, 1);
+    std::vector<CommandBuffer::Stream*> commandStreams;
+    if (deterministic && count > 0) {
+        commandStreams = m_commandBuffer->reserveChunkStreams((count + chunkSize - 1) / chunkSize);
+    }
+
+    jobs.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+        const SystemNode* previousSystem = t_currentSystem;
+        ChunkStamps* previousStamps = t_chunkStamps;
+        CommandBuffer::Stream* previousStream = CommandBuffer::t_chunkStream;
+        const CommandBuffer* previousBuffer = CommandBuffer::t_chunkBuffer;
+        ChunkStamps chunkStamps;
+        t_currentSystem = system;
+        t_chunkStamps = &chunkStamps;
+        if (!commandStreams.empty()) {
+            CommandBuffer::t_chunkStream = commandStreams[begin / chunkSize];
+            CommandBuffer::t_chunkBuffer = m_commandBuffer.get();
+        }
+        func(begin, end);
+        t_currentSystem = previousSystem;
+        t_chunkStamps = previousStamps;
+        CommandBuffer::t_chunkStream = previousStream;
+        CommandBuffer::t_chunkBuffer = previousBuffer;
+
+        if (!chunkStamps.columns.empty() || !chunkStamps.pools.empty()) {
+            std::lock_guard<std::mutex> lock(stampMutex);
+            stamps.columns.insert(stamps.columns.end(), chunkStamps.columns.begin(), chunkStamps.columns.end());
+            stamps.pools.insert(stamps.pools.end(), chunkStamps.pools.begin(), chunkStamps.pools.end());
+        }
+    });
+
+    // Nested inside another chunk, the stamps are handed on to it.
+    const Tick tick = getChangeTick();
+    for (ComponentColumn* column : stamps.columns) {
+        stampColumnChanged(*column, tick);
+    }
+    for (SparseSetBase* pool : stamps.pools) {
+        stampPoolChanged(*pool, tick);
+    }
+}
+
+void World::stampChanged(ComponentColumn& column, size_t row, Tick tick) {
+    if (!t_chunkStamps) {
+        column.markChanged(row, tick);
+        return;
+    }
+    column.ticks()[row].changed = tick;
+    stampColumnChanged(column, tick);
+}
+
+void World::stampChanged(SparseSetBase& pool, std::uint32_t index, Tick tick) {
+    if (!t_chunkStamps) {
+        pool.markChanged(index, tick);
+        return;
+    }
+    pool.ticks()[index].changed = tick;
+    stampPoolChanged(pool, tick);
+}
+
+void World::stampColumnChanged(ComponentColumn& column, Tick tick) {
+    if (!t_chunkStamps) {
+        column.markColumnChanged(tick);
+    }
+    // Columns raised before the chunks were dispatched are only read here, never written.
+    else if (column.getColumnTicks().changed != tick
+        && (t_chunkStamps->columns.empty() || t_chunkStamps->columns.back() != &column)) {
+        t_chunkStamps->columns.push_back(&column);
+    }
+}
+
+void World::stampPoolChanged(SparseSetBase& pool, Tick tick) {
+    if (!t_chunkStamps) {
+        pool.markPoolChanged(tick);
+    }
+    else if (pool.getPoolTicks().changed != tick
+        && (t_chunkStamps->pools.empty() || t_chunkStamps->pools.back() != &pool)) {
+        t_chunkStamps->pools.push_back(&pool);
+    }
+}
+
+void World::checkStructuralChange(const char* operation [[maybe_unused]]) const {
+#ifndef NDEBUG
+    if (t_currentSystem && !t_currentSystem->access.isExclusive()) {
+        LOG_ERROR("World::{}: Structural changes are only allowed from exclusive systems.", operation);
+        assert(false && "Structural change from a concurrently scheduled system");
+    }
+#endif
+}
+
+void World::buildSchedule() {
+    m_schedule.clear();
+    m_schedule.resize(m_systems.size());
+    m_hasConcurrentSystems = false;
+
+    for (size_t i = 0; i < m_systems.size(); i++) {
+        m_schedule[i].access = m_systems[i]->getAccess();
+        if (!m_schedule[i].access.isExclusive()) {
+            m_hasConcurrentSystems = true;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (m_schedule[j].access.conflictsWith(m_schedule[i].access)) {
+                m_schedule[j].dependents.push_back(i);
+                m_schedule[i].dependencyCount++;
+            }
+        }
+    }
+
+    m_scheduleDirty = false;
+}
+
+void World::runSystem(size_t index, float deltaTime) {
+    ISystem& system = *m_systems[index];
+    if (!system.isEnabled()) {
+        return;
+    }
+
+    SystemNode& node = m_schedule[index];
+    node.tick = m_changeTick.fetch_add(1, std::memory_order_relaxed) + 1;
+    const SystemNode* previous = t_currentSystem;
+    t_currentSystem = &node;
+    system.update(deltaTime, *this);
+    t_currentSystem = previous;
+    system.m_lastRunTick = node.tick;
 }
 
 void World::update(float deltaTime) {
-    for (auto& system : m_systems) {
-        if (system->isEnabled()) {
-            system->update(deltaTime, shared_from_this());
+    flushReservedEntities();
+    if (m_scheduleDirty) {
+        buildSchedule();
+    }
+
+    if (!m_hasConcurrentSystems) {
+        for (size_t i = 0; i < m_systems.size(); i++) {
+            runSystem(i, deltaTime);
+        }
+    }
+    else {
+        runSystemsConcurrently(deltaTime);
+    }
+
+    // Deferred commands and anything done between updates get a tick of their own, newer than every
+    // system's last run.
+    m_changeTick.fetch_add(1, std::memory_order_relaxed);
+
+    m_commandBuffer->playback();
+}
+
+void World::runSystemsConcurrently(float deltaTime) {
+    // Each system is released as soon as every earlier system it conflicts with has finished.
+    // Exclusive systems are pinned to the calling thread so they keep main-thread affinity.
+    JobSystem& jobs = getJobSystem();
+    const size_t callerThread = jobs.getCurrentThreadIndex();
+    auto remaining = std::make_unique<std::atomic<size_t>[]>(m_schedule.size());
+    for (size_t i = 0; i < m_schedule.size(); i++) {
+        remaining[i].store(m_schedule[i].dependencyCount, std::memory_order_relaxed);
+    }
+
+    JobSystem::JobCounter counter{ 0 };
+    std::function<void(size_t)> dispatch = [&](size_t index) {
+        JobSystem::Job job = [&, index]() {
+            runSystem(index, deltaTime);
+            for (size_t dependent : m_schedule[index].dependents) {
+                if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    dispatch(dependent);
+                }
+            }
+        };
+        if (m_schedule[index].access.isExclusive()) {
+            jobs.submitTo(callerThread, std::move(job), counter);
+        }
+        else {
+            jobs.submit(std::move(job), counter);
+        }
+    };
+
+    for (size_t i = 0; i < m_schedule.size(); i++) {
+        if (m_schedule[i].dependencyCount == 0) {
+            dispatch(i);
         }
     }
+    jobs.wait(counter);
 }
 
 void World::init() {
 
     for (auto& system : m_systems) {
-        system->onAddedToWorld(shared_from_this());
+        system->onAddedToWorld(*this);
     }
 }
 
 void World::shutdown() {
+    flushReservedEntities();
+    m_commandBuffer->clear();
 
     for (auto& system : m_systems) {
-        system->onRemovedFromWorld(shared_from_this());
+        system->onRemovedFromWorld(*this);
     }
-    m_components.clear();
-    m_entityMasks.clear();
-    m_entities.clear();
+    clearEntities();
+    m_resources.clear();
     m_systems.clear();
     m_systemMap.clear();
-}
\ No newline at end of file
+    m_schedule.clear();
+    m_scheduleDirty = true;
+}
@@ -5,8 +5,10 @@
 #include "spdlog/spdlog.h"
 #include "graphics/Pipeline.h"
 #include "graphics/Shader.h"
+#include "ecs/TransformSystem.h"
+#include "graphics/UniformBlocks.h"
 
-Game::Game() : m_window(nullptr), m_shaderProgram(0), m_VAO(0), m_VBO(0), m_lastFrameTime(0.0f) {
+Game::Game() : m_window(nullptr), m_headless(false), m_shaderProgram(0), m_VAO(0), m_VBO(0), m_timestep(60.0, 5), m_pacer(144.0), m_simulationTime(0.0) {
 
 }
 
@@ -20,6 +22,10 @@ void Game::init(GLFWwindow* window) {
         spdlog::error("ERROR::GAME::INIT: window is null");
         return;
     }
+    m_pipeline = std::make_unique<Pipeline>();
+    m_frameUniforms = std::make_unique<StreamingBuffer>(GL_UNIFORM_BUFFER, 4096);
+    m_instanceStream = std::make_unique<StreamingBuffer>(GL_ARRAY_BUFFER, INSTANCE_STREAM_BYTES);
+    setupWorld();
     spdlog::info("Game initialized with window. IMPORTANT: Ensure gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) was called successfully AFTER glfwMakeContextCurrent in your main setup code (e.g., main.cpp or Window class).");
 
     loadShaders();
@@ -28,13 +34,40 @@ void Game::init(GLFWwindow* window) {
         spdlog::info("Shaders loaded and shader program ID is: {}. Proceeding to set up game objects.", m_shaderProgram);
         setupGameObjects();
         spdlog::info("Game objects set up successfully.");
-        m_lastFrameTime = static_cast<float>(glfwGetTime());
     }
     else {
         spdlog::error("Shader loading failed or was incomplete. Shader program ID is 0. Game objects will not be set up.");
     }
 }
 
+void Game::initHeadless(size_t workerThreads) {
+    m_headless = true;
+    m_world.setJobSystem(std::make_shared<JobSystem>(workerThreads));
+    setupWorld();
+    spdlog::info("Game initialized headless with {} job threads.", m_world.getJobSystem().getThreadCount());
+}
+
+void Game::setupWorld() {
+    m_world.addSystem<TransformSystem>();
+}
+
+void Game::spawnTestEntities(size_t count) {
+    const size_t groupSize = 8;
+    for (size_t first = 0; first < count; first += groupSize) {
+        EntityID root = m_world.createEntity();
+        m_world.addComponent<LocalTransform>(root, LocalTransform{ glm::vec3(static_cast<float>(first), 0.0f, 0.0f) });
+        m_world.addComponent<WorldTransform>(root);
+        m_world.addComponent<Spin>(root, Spin{ 0.5f + static_cast<float>(first % 7) * 0.25f });
+
+        for (size_t i = first + 1; i < std::min(first + groupSize, count); i++) {
+            EntityID child = m_world.createEntity();
+            m_world.addComponent<LocalTransform>(child, LocalTransform{ glm::vec3(1.0f, static_cast<float>(i - first), 0.0f) });
+            m_world.addComponent<WorldTransform>(child);
+            Hierarchy::setParent(m_world, child, root);
+        }
+    }
+}
+
 void Game::loadShaders() {
 
     try {
@@ -58,21 +91,22 @@ void Game::loadShaders() {
         }
 
         LOG_INFO("Start attaching shaders to pipeline.");
-        m_pipeline.attachShader(std::move(vertexShader));
-        m_pipeline.attachShader(std::move(fragmentShader));
+        m_pipeline->attachShader(std::move(vertexShader));
+        m_pipeline->attachShader(std::move(fragmentShader));
         LOG_INFO("Shaders attached to pipeline. Vertex Shader ID: {}, Fragment Shader ID: {}",
-            m_pipeline.findShaderID("VertexShader"), m_pipeline.findShaderID("FragmentShader"));
-        m_pipeline.link();
+            m_pipeline->findShaderID("VertexShader"), m_pipeline->findShaderID("FragmentShader"));
+        m_pipeline->link();
 
-        if (m_pipeline.isLinked()) {
-            m_shaderProgram = m_pipeline.getID(); // Get the program ID
+        if (m_pipeline->isLinked()) {
+            m_shaderProgram = m_pipeline->getID(); // Get the program ID
+            m_colorUniform = m_pipeline->getUniformHandle("ourColor");
             spdlog::info("Shader program linked successfully. ID: {}", m_shaderProgram);
         }
         else {
-            spdlog::error("Shader pipeline linking failed: {}", m_pipeline.getInfoLog());
+            spdlog::error("Shader pipeline linking failed: {}", m_pipeline->getInfoLog());
             m_shaderProgram = 0;
         }
-        m_pipeline.use();
+        m_pipeline->use();
     }
     catch (const std::exception& e) {
         spdlog::error("Exception during shader loading: {}", e.what());
@@ -86,17 +120,61 @@ void Game::setupGameObjects() {
 }
 
 void Game::run() {
-    while (!glfwWindowShouldClose(m_window)) {
-        float currentFrameTime = static_cast<float>(glfwGetTime());
-        float deltaTime = currentFrameTime - m_lastFrameTime;
-        m_lastFrameTime = currentFrameTime;
+    using Clock = std::chrono::steady_clock;
+
+    if (m_headless || !m_window) {
+        spdlog::error("Game::run: No window; use runHeadless() for headless games.");
+        return;
+    }
+
+    m_stopRequested.store(false, std::memory_order_relaxed);
+    m_timestep.reset();
+    m_pacer.reset();
+    Clock::time_point lastFrameTime = Clock::now();
+    while (!glfwWindowShouldClose(m_window) && !m_stopRequested.load(std::memory_order_relaxed)) {
+        Clock::time_point currentFrameTime = Clock::now();
+        double frameSeconds = std::chrono::duration<double>(currentFrameTime - lastFrameTime).count();
+        lastFrameTime = currentFrameTime;
+
         processInput();
-        update(deltaTime);
-        render();
+        int steps = m_timestep.advance(frameSeconds);
+        for (int i = 0; i < steps; i++) {
+            update(m_timestep.getStepSeconds());
+        }
+        render(m_timestep.getAlpha());
 
         glfwSwapBuffers(m_window);
         glfwPollEvents();
+        GLStateCache::endFrame();
+        m_pacer.wait();
+    }
+}
+
+double Game::runHeadless(std::uint64_t ticks) {
+    using Clock = std::chrono::steady_clock;
+
+    m_stopRequested.store(false, std::memory_order_relaxed);
+    float step = m_timestep.getStepSeconds();
+    if (ticks == 0) {
+        // Server loop: one tick per period, sleeping in between so idle servers cost next to nothing.
+        FramePacer pacer(m_timestep.getTickRate());
+        while (!m_stopRequested.load(std::memory_order_relaxed)) {
+            update(step);
+            pacer.wait();
+        }
+        return 0.0;
     }
+
+    Clock::time_point start = Clock::now();
+    std::uint64_t tick = 0;
+    for (; tick < ticks && !m_stopRequested.load(std::memory_order_relaxed); tick++) {
+        update(step);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double ticksPerSecond = seconds > 0.0 ? static_cast<double>(tick) / seconds : 0.0;
+    spdlog::info("Headless: {} ticks in {:.3f}s ({:.1f} ticks/s, {:.3f}ms/tick).", tick, seconds, ticksPerSecond,
+        tick > 0 ? seconds * 1000.0 / static_cast<double>(tick) : 0.0);
+    return ticksPerSecond;
 }
 
 void Game::processInput() {
@@ -104,31 +182,81 @@ void Game::processInput() {
         glfwSetWindowShouldClose(m_window, true);
 }
 
-void Game::update(float deltaTime [[maybe_unused]] ) {
-
-    float timeValue = glfwGetTime();
-    float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
-    float redValue = (cos(timeValue) / 2.0f) + 0.5f;
-    float blueValue = (sin(timeValue) / 2.0f) + 0.5f;
-    glm::vec4 color(redValue, greenValue, blueValue, 1.0f);
-    m_pipeline.setUniform("ourColor", color);
+void Game::update(float deltaTime) {
+    m_world.forEach<LocalTransform, const Spin>([deltaTime](EntityID, LocalTransform& transform, const Spin& spin) {
+        transform.rotation = glm::angleAxis(spin.radiansPerSecond * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f)) * transform.rotation;
+    });
+    m_world.update(deltaTime);
 
+    // Advanced by the fixed step rather than read from the wall clock, so every run animates identically.
+    m_simulationTime += deltaTime;
 }
 
-void Game::render() {
+void Game::render(float alpha) {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    glUseProgram(m_shaderProgram);
-    glBindVertexArray(m_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    glBindVertexArray(0);
+    // One FrameUniforms block per frame, bound once for every pipeline.
+    m_frameUniforms->beginFrame();
+    StreamingBuffer::Allocation frameBlock = m_frameUniforms->allocate(sizeof(FrameUniforms), StreamingBuffer::getUniformOffsetAlignment());
+    if (frameBlock) {
+        FrameUniforms frame;
+        frame.time = static_cast<float>(m_simulationTime);
+        frame.deltaTime = m_timestep.getStepSeconds();
+        frame.alpha = alpha;
+        std::memcpy(frameBlock.data, &frame, sizeof(frame));
+        GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, FrameUniforms::BINDING, m_frameUniforms->getID(), frameBlock.offset, sizeof(FrameUniforms));
+    }
+    m_frameUniforms->flush();
+    m_instanceStream->beginFrame();
+
+    if (m_shaderProgram != 0) {
+        float timeValue = static_cast<float>(m_simulationTime);
+        float greenValue = (sin(timeValue) / 2.0f) + 0.5f;
+        float redValue = (cos(timeValue) / 2.0f) + 0.5f;
+        float blueValue = (sin(timeValue) / 2.0f) + 0.5f;
+        glm::vec4 color(redValue, greenValue, blueValue, 1.0f);
+
+        m_pipeline->use();
+        m_pipeline->setUniform(m_colorUniform, color);
+        GLStateCache::bindVertexArray(m_VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        GLStateCache::recordCall();
+    }
+
+    m_renderQueue.execute(m_instanceStream.get());
+    m_renderQueue.clear();
+
+    // Entities with a MeshRenderer, one instanced draw per mesh and pipeline.
+    m_batcher.build(m_world);
+    m_batcher.draw(m_instanceStream.get());
+
+    m_instanceStream->endFrame();
+    m_frameUniforms->endFrame();
+
+    if (++m_renderedFrames % STATS_LOG_INTERVAL == 0) {
+        const RenderQueue::Stats& queue = m_renderQueue.getStats();
+        const InstanceBatcher::DrawStats& batches = m_batcher.getDrawStats();
+        LOG_INFO("Game::render: {} instanced draws ({} via fallback), {} instance bytes; instance stream stalled {} times so far.",
+            queue.drawCalls + batches.drawCalls, queue.fallbackDraws + batches.fallbackDraws,
+            queue.uploadBytes + batches.uploadBytes, m_instanceStream->getStallCount());
+    }
 }
 
 void Game::cleanup() {
+    m_world.shutdown();
+    if (!m_window) {
+        return;
+    }
+    // The pipeline owns and deletes m_shaderProgram.
+    m_pipeline.reset();
+    m_frameUniforms.reset();
+    m_instanceStream.reset();
+    GLStateCache::onVertexArrayDeleted(m_VAO);
+    GLStateCache::onBufferDeleted(m_VBO);
     glDeleteVertexArrays(1, &m_VAO);
     glDeleteBuffers(1, &m_VBO);
-    glDeleteProgram(m_shaderProgram);
+    m_window = nullptr;
 }
 
 
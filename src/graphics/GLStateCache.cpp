@@ -0,0 +1,237 @@
+#include "pch.h"
+#include "graphics/GLStateCache.h"
+
+GLuint GLStateCache::s_program = UNKNOWN;
+GLuint GLStateCache::s_vertexArray = UNKNOWN;
+std::array<GLuint, GLStateCache::BUFFER_SLOT_COUNT> GLStateCache::s_buffers = [] {
+    std::array<GLuint, BUFFER_SLOT_COUNT> buffers;
+    buffers.fill(UNKNOWN);
+    return buffers;
+}();
+std::array<GLStateCache::IndexedBinding, GLStateCache::MAX_UNIFORM_BINDINGS> GLStateCache::s_uniformBindings = [] {
+    std::array<IndexedBinding, MAX_UNIFORM_BINDINGS> bindings;
+    bindings.fill(IndexedBinding{ UNKNOWN, 0, 0 });
+    return bindings;
+}();
+GLuint GLStateCache::s_activeTextureUnit = UNKNOWN;
+std::array<std::array<GLuint, GLStateCache::TEXTURE_SLOT_COUNT>, GLStateCache::MAX_TEXTURE_UNITS> GLStateCache::s_textures = [] {
+    std::array<std::array<GLuint, TEXTURE_SLOT_COUNT>, MAX_TEXTURE_UNITS> textures;
+    for (auto& unit : textures) {
+        unit.fill(UNKNOWN);
+    }
+    return textures;
+}();
+GLStateCache::Toggle GLStateCache::s_blend = Toggle::UNKNOWN;
+GLenum GLStateCache::s_blendSource = UNKNOWN;
+GLenum GLStateCache::s_blendDestination = UNKNOWN;
+GLStateCache::Toggle GLStateCache::s_depthTest = Toggle::UNKNOWN;
+GLenum GLStateCache::s_depthFunc = UNKNOWN;
+GLStateCache::Toggle GLStateCache::s_depthMask = Toggle::UNKNOWN;
+GLStateCache::FrameStats GLStateCache::s_frameStats;
+GLStateCache::FrameStats GLStateCache::s_lastFrameStats;
+
+int GLStateCache::getBufferSlot(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return ARRAY;
+    case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_ARRAY;
+    case GL_UNIFORM_BUFFER: return UNIFORM;
+    case GL_COPY_READ_BUFFER: return COPY_READ;
+    case GL_COPY_WRITE_BUFFER: return COPY_WRITE;
+    case GL_PIXEL_UNPACK_BUFFER: return PIXEL_UNPACK;
+    case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT;
+    default: return -1;
+    }
+}
+
+int GLStateCache::getTextureSlot(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D: return TEXTURE_2D;
+    case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+    case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+    default: return -1;
+    }
+}
+
+void GLStateCache::useProgram(GLuint program) {
+    if (count(s_program != program)) {
+        glUseProgram(program);
+        s_program = program;
+    }
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+    if (count(s_vertexArray != vao)) {
+        glBindVertexArray(vao);
+        s_vertexArray = vao;
+        s_buffers[ELEMENT_ARRAY] = UNKNOWN;
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    int slot = getBufferSlot(target);
+    if (slot < 0) {
+        count(true);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (count(s_buffers[slot] != buffer)) {
+        glBindBuffer(target, buffer);
+        s_buffers[slot] = buffer;
+    }
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    bool cached = target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS;
+    IndexedBinding binding{ buffer, 0, -1 };
+    if (!count(!cached || s_uniformBindings[index] != binding)) {
+        return;
+    }
+    glBindBufferBase(target, index, buffer);
+    if (cached) {
+        s_uniformBindings[index] = binding;
+    }
+    // glBindBufferBase also sets the generic binding point.
+    int slot = getBufferSlot(target);
+    if (slot >= 0) {
+        s_buffers[slot] = buffer;
+    }
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    bool cached = target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS;
+    IndexedBinding binding{ buffer, offset, size };
+    if (!count(!cached || s_uniformBindings[index] != binding)) {
+        return;
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+    if (cached) {
+        s_uniformBindings[index] = binding;
+    }
+    int slot = getBufferSlot(target);
+    if (slot >= 0) {
+        s_buffers[slot] = buffer;
+    }
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    int slot = getTextureSlot(target);
+    if (unit >= MAX_TEXTURE_UNITS || slot < 0) {
+        count(true);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        s_activeTextureUnit = unit;
+        return;
+    }
+    if (!count(s_textures[unit][slot] != texture)) {
+        return;
+    }
+    if (count(s_activeTextureUnit != unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        s_activeTextureUnit = unit;
+    }
+    glBindTexture(target, texture);
+    s_textures[unit][slot] = texture;
+}
+
+void GLStateCache::setToggle(Toggle& cached, GLenum capability, bool enabled) {
+    Toggle wanted = enabled ? Toggle::ON : Toggle::OFF;
+    if (count(cached != wanted)) {
+        if (enabled) {
+            glEnable(capability);
+        }
+        else {
+            glDisable(capability);
+        }
+        cached = wanted;
+    }
+}
+
+void GLStateCache::setBlend(bool enabled) {
+    setToggle(s_blend, GL_BLEND, enabled);
+}
+
+void GLStateCache::setBlendFunc(GLenum source, GLenum destination) {
+    if (count(s_blendSource != source || s_blendDestination != destination)) {
+        glBlendFunc(source, destination);
+        s_blendSource = source;
+        s_blendDestination = destination;
+    }
+}
+
+void GLStateCache::setDepthTest(bool enabled) {
+    setToggle(s_depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLStateCache::setDepthFunc(GLenum func) {
+    if (count(s_depthFunc != func)) {
+        glDepthFunc(func);
+        s_depthFunc = func;
+    }
+}
+
+void GLStateCache::setDepthMask(bool writeEnabled) {
+    Toggle wanted = writeEnabled ? Toggle::ON : Toggle::OFF;
+    if (count(s_depthMask != wanted)) {
+        glDepthMask(writeEnabled ? GL_TRUE : GL_FALSE);
+        s_depthMask = wanted;
+    }
+}
+
+void GLStateCache::onProgramDeleted(GLuint program) {
+    // A program in use stays current until another is bound, so only forget it.
+    if (s_program == program) {
+        s_program = UNKNOWN;
+    }
+}
+
+void GLStateCache::onVertexArrayDeleted(GLuint vao) {
+    if (s_vertexArray == vao) {
+        s_vertexArray = 0;
+        s_buffers[ELEMENT_ARRAY] = UNKNOWN;
+    }
+}
+
+void GLStateCache::onBufferDeleted(GLuint buffer) {
+    for (GLuint& bound : s_buffers) {
+        if (bound == buffer) {
+            bound = 0;
+        }
+    }
+    for (IndexedBinding& binding : s_uniformBindings) {
+        if (binding.buffer == buffer) {
+            binding = IndexedBinding{ 0, 0, -1 };
+        }
+    }
+}
+
+void GLStateCache::onTextureDeleted(GLuint texture) {
+    for (auto& unit : s_textures) {
+        for (GLuint& bound : unit) {
+            if (bound == texture) {
+                bound = 0;
+            }
+        }
+    }
+}
+
+void GLStateCache::invalidate() {
+    s_program = UNKNOWN;
+    s_vertexArray = UNKNOWN;
+    s_buffers.fill(UNKNOWN);
+    s_uniformBindings.fill(IndexedBinding{ UNKNOWN, 0, 0 });
+    s_activeTextureUnit = UNKNOWN;
+    for (auto& unit : s_textures) {
+        unit.fill(UNKNOWN);
+    }
+    s_blend = Toggle::UNKNOWN;
+    s_blendSource = UNKNOWN;
+    s_blendDestination = UNKNOWN;
+    s_depthTest = Toggle::UNKNOWN;
+    s_depthFunc = UNKNOWN;
+    s_depthMask = Toggle::UNKNOWN;
+}
+
+void GLStateCache::endFrame() {
+    s_lastFrameStats = s_frameStats;
+    s_frameStats = FrameStats{};
+}
@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "graphics/InstanceBatcher.h"
+
+void InstanceBatcher::build(World& world) {
+    for (Batch& batch : m_batches) {
+        batch.instances.clear();
+    }
+
+    // Consecutive entities usually share their mesh, so remember the last batch to skip the map lookup.
+    Batch* current = nullptr;
+    m_instanceCount = 0;
+    world.query<const MeshRenderer, const WorldTransform>().forEach(
+        [&](EntityID, const MeshRenderer& renderer, const WorldTransform& transform) {
+            if (!renderer.mesh || !renderer.pipeline) {
+                return;
+            }
+            BatchKey key{ renderer.pipeline, renderer.mesh };
+            if (!current || current->key.pipeline != key.pipeline || current->key.mesh != key.mesh) {
+                auto [it, inserted] = m_batchIndices.try_emplace(key, m_batches.size());
+                if (inserted) {
+                    m_batches.push_back(Batch{ key, {} });
+                }
+                current = &m_batches[it->second];
+            }
+            current->instances.push_back(InstanceData{ transform.matrix, renderer.color });
+            m_instanceCount++;
+        });
+
+    // Drop batches that drew nothing this frame, so keys of meshes and pipelines that are gone (and may
+    // since have been freed) do not pile up. Batches in use keep their storage.
+    auto firstEmpty = std::remove_if(m_batches.begin(), m_batches.end(),
+        [](const Batch& batch) { return batch.instances.empty(); });
+    if (firstEmpty != m_batches.end()) {
+        m_batches.erase(firstEmpty, m_batches.end());
+        m_batchIndices.clear();
+        for (size_t i = 0; i < m_batches.size(); i++) {
+            m_batchIndices.emplace(m_batches[i].key, i);
+        }
+    }
+}
+
+void InstanceBatcher::draw(StreamingBuffer* stream) {
+    // Every batch is written before the first draw, so a stream without persistent mapping uploads
+    // them all with a single flush.
+    m_drawStats = DrawStats{};
+    m_allocations.assign(m_batches.size(), StreamingBuffer::Allocation{});
+    if (stream) {
+        for (size_t i = 0; i < m_batches.size(); i++) {
+            const std::vector<InstanceData>& instances = m_batches[i].instances;
+            m_allocations[i] = stream->allocateElements(instances.size(), sizeof(InstanceData));
+            if (m_allocations[i]) {
+                std::memcpy(m_allocations[i].data, instances.data(), instances.size() * sizeof(InstanceData));
+            }
+        }
+        stream->flush();
+    }
+
+    for (const auto& [key, index] : m_batchIndices) {
+        key.pipeline->use();
+        const std::vector<InstanceData>& instances = m_batches[index].instances;
+        if (m_allocations[index]) {
+            key.mesh->drawInstanced(*stream, m_allocations[index], instances.size());
+        }
+        else {
+            key.mesh->drawInstanced(instances);
+            m_drawStats.fallbackDraws++;
+        }
+        m_drawStats.drawCalls++;
+        m_drawStats.uploadBytes += instances.size() * sizeof(InstanceData);
+    }
+}
@@ -1,4 +1,5 @@
 #include "graphics/Mesh.h"
+#include "graphics/GLStateCache.h"
 
 
 void Mesh::setupMesh() {
@@ -7,14 +8,14 @@ void Mesh::setupMesh() {
     glGenBuffers(1, &m_EBO);
     LOG_INFO("Mesh::setupMesh: Generated VAO: {}, VBO: {}, EBO: {}", m_VAO, m_VBO, m_EBO);
 
-    glBindVertexArray(m_VAO);
+    GLStateCache::bindVertexArray(m_VAO);
     LOG_INFO("Mesh::setupMesh: Bound VAO: {}", m_VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
     glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), m_vertices.data(), GL_STATIC_DRAW);
     LOG_INFO("Mesh::setupMesh: Bound VBO: {} with size: {}", m_VBO, m_vertices.size() * sizeof(Vertex));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
     LOG_INFO("Mesh::setupMesh: Bound EBO: {} with size: {}", m_EBO, m_indices.size() * sizeof(unsigned int));
 
@@ -25,22 +26,151 @@ void Mesh::setupMesh() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
     glEnableVertexAttribArray(2);
     LOG_INFO("Mesh::setupMesh: Set vertex attribute pointers for position, normal, and texCoords.");
-    glBindVertexArray(0); // Unbind VAO
+    // Unbind so that later element buffer binds cannot land in this VAO.
+    GLStateCache::bindVertexArray(0);
     LOG_INFO("Mesh::setupMesh: Unbound VAO: {}", m_VAO);
 }
 
 void Mesh::bind() const {
-    glBindVertexArray(m_VAO);
-    LOG_INFO("Mesh::bind: Bound VAO: {}", m_VAO);
+    GLStateCache::bindVertexArray(m_VAO);
 }
 
 void Mesh::unbind() const {
-    glBindVertexArray(0);
-    LOG_INFO("Mesh::unbind: Unbound VAO: {}", m_VAO);
+    GLStateCache::bindVertexArray(0);
 }
 
+// Draws leave the VAO bound; the state cache skips the rebind when the same mesh is drawn next.
 void Mesh::draw() const {
-    glBindVertexArray(m_VAO);
+    bind();
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    GLStateCache::recordCall();
+}
+
+void Mesh::setInstanceSource(GLuint buffer, GLintptr offset) {
+    bind();
+    if (m_instanceAttributesEnabled && buffer == m_instanceSource && offset == m_instanceSourceOffset) {
+        return;
+    }
+
+    // A mat4 attribute takes four consecutive locations, one vec4 column each.
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(offset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, color)));
+    GLStateCache::recordCall(5);
+
+    if (!m_instanceAttributesEnabled) {
+        for (GLuint location = INSTANCE_MODEL_LOCATION; location <= INSTANCE_COLOR_LOCATION; location++) {
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        GLStateCache::recordCall(10);
+        m_instanceAttributesEnabled = true;
+    }
+    m_instanceSource = buffer;
+    m_instanceSourceOffset = offset;
+}
+
+void Mesh::drawInstanced(const StreamingBuffer& stream, const StreamingBuffer::Allocation& allocation, size_t count) {
+    if (count == 0 || !allocation) {
+        return;
+    }
+    GLsizei indexCount = static_cast<GLsizei>(m_indices.size());
+    if (GLAD_GL_VERSION_4_2) {
+        setInstanceSource(stream.getID(), 0);
+        GLuint baseInstance = static_cast<GLuint>(allocation.offset / static_cast<GLintptr>(sizeof(InstanceData)));
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count), baseInstance);
+    }
+    else {
+        setInstanceSource(stream.getID(), allocation.offset);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
+    }
+    GLStateCache::recordCall();
+}
+
+void Mesh::drawInstanced(const InstanceData* instances, size_t count, StreamingBuffer* stream) {
+    if (count == 0) {
+        return;
+    }
+    StreamingBuffer::Allocation allocation = stream ? stream->allocateElements(count, sizeof(InstanceData)) : StreamingBuffer::Allocation{};
+    if (!allocation) {
+        drawInstancedFallback(instances, count);
+        return;
+    }
+    std::memcpy(allocation.data, instances, count * sizeof(InstanceData));
+    stream->flush();
+    drawInstanced(*stream, allocation, count);
+}
+
+void Mesh::drawInstancedFallback(const InstanceData* instances, size_t count) {
+    if (m_instanceVBO == 0) {
+        glGenBuffers(1, &m_instanceVBO);
+        LOG_INFO("Mesh::drawInstancedFallback: Generated instance VBO: {} for VAO: {}", m_instanceVBO, m_VAO);
+    }
+
+    // The storage is only reallocated to grow; otherwise it is overwritten in place.
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    if (count > m_instanceCapacity) {
+        m_instanceCapacity = std::max(count, m_instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+        GLStateCache::recordCall();
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), instances);
+    GLStateCache::recordCall();
+
+    setInstanceSource(m_instanceVBO, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
+    GLStateCache::recordCall();
+}
+
+bool Mesh::checkInstanceLayout(GLuint program) {
+    GLint attributeCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+
+    bool valid = true;
+    bool hasModel = false;
+    std::string name(static_cast<size_t>(std::max(maxNameLength, 1)), '\0');
+    for (GLint i = 0; i < attributeCount; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        GLint location = glGetAttribLocation(program, name.c_str());
+        if (location < 0) {
+            continue; // Built-ins such as gl_VertexID.
+        }
+
+        // Matrices take one location per column.
+        GLint columns = 1;
+        switch (type) {
+        case GL_FLOAT_MAT2: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: columns = 2; break;
+        case GL_FLOAT_MAT3: case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3x4: columns = 3; break;
+        case GL_FLOAT_MAT4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3: columns = 4; break;
+        default: break;
+        }
+        GLint first = location;
+        GLint last = location + columns * size - 1;
+        if (last < static_cast<GLint>(INSTANCE_MODEL_LOCATION) || first > static_cast<GLint>(INSTANCE_COLOR_LOCATION)) {
+            continue;
+        }
+
+        if (location == static_cast<GLint>(INSTANCE_MODEL_LOCATION) && type == GL_FLOAT_MAT4 && size == 1) {
+            hasModel = true;
+        }
+        else if (location != static_cast<GLint>(INSTANCE_COLOR_LOCATION) || type != GL_FLOAT_VEC4 || size != 1) {
+            LOG_ERROR("Mesh::checkInstanceLayout: Program {} has attribute '{}' at location {}, which overlaps the instance attributes (mat4 at {}, vec4 at {}).",
+                program, name.c_str(), location, INSTANCE_MODEL_LOCATION, INSTANCE_COLOR_LOCATION);
+            valid = false;
+        }
+    }
+    if (!hasModel) {
+        LOG_ERROR("Mesh::checkInstanceLayout: Program {} does not read the instance model matrix as a mat4 at location {}.", program, INSTANCE_MODEL_LOCATION);
+        valid = false;
+    }
+    return valid;
+}
@@ -1,4 +1,6 @@
 #include "graphics/Pipeline.h"
+#include "graphics/GLStateCache.h"
+#include "graphics/UniformBlocks.h"
 
 
 Pipeline::Pipeline() : m_programID(0), m_isLinked(false) {
@@ -13,6 +15,7 @@ Pipeline::Pipeline() : m_programID(0), m_isLinked(false) {
 
 Pipeline::~Pipeline() {
     if (m_programID != 0) {
+        GLStateCache::onProgramDeleted(m_programID);
         glDeleteProgram(m_programID);
         LOG_INFO("Pipeline::~Pipeline: Shader program (ID: {}) deleted successfully.", m_programID);
     }
@@ -63,6 +66,7 @@ void Pipeline::link(bool detachShaderAfterLink) {
     if (!successLink) {
         glGetProgramInfoLog(m_programID, 512, NULL, infoLogLink);
         LOG_ERROR("Pipeline::link: ERROR::SHADER::PROGRAM::LINKING_FAILED(ID : {})\n{}", m_programID, infoLogLink);
+        GLStateCache::onProgramDeleted(m_programID);
         glDeleteProgram(m_programID);
         m_programID = 0;
         m_isLinked = false;
@@ -70,6 +74,7 @@ void Pipeline::link(bool detachShaderAfterLink) {
     else {
         m_isLinked = true;
         LOG_INFO("Pipeline::link: Successfully linked shader program (ID: {}).", m_programID);
+        bindUniformBlock(FrameUniforms::BLOCK_NAME, FrameUniforms::BINDING);
         if (detachShaderAfterLink) {
             detachAllShaders();
             LOG_INFO("Pipeline::link: All shaders detached after linking program (ID: {}).", m_programID);
@@ -118,8 +123,7 @@ void Pipeline::use() const
         LOG_ERROR("Pipeline::use: Shader program has not been created or linked.");
         return;
     }
-    glUseProgram(m_programID);
-    LOG_INFO("Pipeline::use: Using shader program (ID: {}).", m_programID);
+    GLStateCache::useProgram(m_programID);
 }
 
 
@@ -131,60 +135,109 @@ void Pipeline::detachShader(std::unique_ptr<Shader> shader) {
     LOG_INFO("Sucessfully detach shader {}", shader->getName());
 }
 
-void Pipeline::setUniform(const std::string& name, int value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform1i(location, value);
+void Pipeline::checkCurrent() const {
+#ifndef NDEBUG
+    if (GLStateCache::getProgram() != m_programID) {
+        LOG_ERROR("Pipeline::setUniform: program {} is not bound, call use() first", m_programID);
     }
+#endif
 }
 
-void Pipeline::setUniform(const std::string& name, float value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform1f(location, value);
+void Pipeline::setUniform(UniformHandle handle, int value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform1i(handle.location, value);
     }
 }
 
-void Pipeline::setUniform(const std::string& name, bool value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform1i(location, value ? 1 : 0);
+void Pipeline::setUniform(UniformHandle handle, float value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform1f(handle.location, value);
     }
 }
 
-void Pipeline::setUniform(const std::string& name, const glm::vec2& value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform2fv(location, 1, &value[0]);
+void Pipeline::setUniform(UniformHandle handle, bool value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform1i(handle.location, value ? 1 : 0);
     }
 }
 
-void Pipeline::setUniform(const std::string& name, const glm::vec3& value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform3fv(location, 1, &value[0]);
+void Pipeline::setUniform(UniformHandle handle, const glm::vec2& value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform2fv(handle.location, 1, &value[0]);
     }
 }
 
-void Pipeline::setUniform(const std::string& name, const glm::vec4& value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniform4fv(location, 1, &value[0]);
+void Pipeline::setUniform(UniformHandle handle, const glm::vec3& value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform3fv(handle.location, 1, &value[0]);
     }
 }
 
-void Pipeline::setUniform(const std::string& name, const glm::mat3& value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+void Pipeline::setUniform(UniformHandle handle, const glm::vec4& value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniform4fv(handle.location, 1, &value[0]);
+    }
+}
+
+void Pipeline::setUniform(UniformHandle handle, const glm::mat3& value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, &value[0][0]);
     }
 }
 
+void Pipeline::setUniform(UniformHandle handle, const glm::mat4& value) const {
+    if (handle.isValid()) {
+        checkCurrent();
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &value[0][0]);
+    }
+}
+
+void Pipeline::setUniform(const std::string& name, int value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, float value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, bool value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, const glm::vec2& value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, const glm::vec3& value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, const glm::vec4& value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
+void Pipeline::setUniform(const std::string& name, const glm::mat3& value) const {
+    setUniform(getUniformHandle(name), value);
+}
+
 void Pipeline::setUniform(const std::string& name, const glm::mat4& value) const {
-    GLint location = getUniformLocation(name);
-    if (location != -1) {
-        glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+    setUniform(getUniformHandle(name), value);
+}
+
+bool Pipeline::bindUniformBlock(const char* blockName, GLuint binding) const {
+    GLuint blockIndex = glGetUniformBlockIndex(m_programID, blockName);
+    if (blockIndex == GL_INVALID_INDEX) {
+        return false;
     }
+    glUniformBlockBinding(m_programID, blockIndex, binding);
+    return true;
 }
 
 GLint Pipeline::getUniformLocation(const std::string& name) const {
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "graphics/RenderQueue.h"
+
+std::uint64_t RenderQueue::getDenseIndex(std::unordered_map<GLuint, std::uint32_t>& indices, GLuint name, std::uint32_t limit) {
+    std::uint32_t index = indices.try_emplace(name, static_cast<std::uint32_t>(indices.size())).first->second;
+    return std::min(index, limit);
+}
+
+std::uint64_t RenderQueue::makeKey(const RenderPacket& packet) {
+#ifndef NDEBUG
+    if (m_programIndices.find(packet.pipeline->getID()) == m_programIndices.end()) {
+        Mesh::checkInstanceLayout(packet.pipeline->getID());
+    }
+#endif
+    std::uint64_t program = getDenseIndex(m_programIndices, packet.pipeline->getID(), 0xFFFu);
+    std::uint64_t texture = getDenseIndex(m_textureIndices, packet.texture, 0xFFFFu);
+    std::uint64_t vao = getDenseIndex(m_vaoIndices, packet.mesh->getVAO(), 0xFFFu);
+    // For non-negative floats the IEEE bit pattern orders like the value, so its top bits are a
+    // ready-made quantised depth.
+    std::uint32_t depthBits;
+    float depth = std::max(packet.depth, 0.0f);
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return (program << 52) | (texture << 36) | (vao << 24) | (depthBits >> 7);
+}
+
+void RenderQueue::reserve(size_t packets) {
+    m_packets.reserve(packets);
+    m_items.reserve(packets);
+    m_scratch.reserve(packets);
+    m_instances.reserve(packets);
+}
+
+void RenderQueue::submit(const RenderPacket& packet) {
+    if (!packet.pipeline || !packet.mesh) {
+        LOG_ERROR("RenderQueue::submit: Packet has no pipeline or mesh.");
+        return;
+    }
+    m_items.push_back(SortItem{ makeKey(packet), static_cast<std::uint32_t>(m_packets.size()) });
+    m_packets.push_back(packet);
+    m_sorted = false;
+}
+
+void RenderQueue::clear() {
+    m_packets.clear();
+    m_items.clear();
+    m_programIndices.clear();
+    m_textureIndices.clear();
+    m_vaoIndices.clear();
+    m_sorted = true;
+}
+
+void RenderQueue::sort() {
+    if (m_sorted) {
+        return;
+    }
+    radixSort();
+    m_sorted = true;
+}
+
+void RenderQueue::radixSort() {
+    // LSD radix sort, one byte per pass. All histograms are built in a single read, and passes whose
+    // byte is the same for every key (e.g. the unused high bits of small indices) are skipped.
+    const size_t count = m_items.size();
+    std::array<std::array<std::uint32_t, 256>, 8> histograms{};
+    for (const SortItem& item : m_items) {
+        for (size_t pass = 0; pass < 8; pass++) {
+            histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    m_scratch.resize(count);
+    for (size_t pass = 0; pass < 8; pass++) {
+        auto& histogram = histograms[pass];
+        if (histogram[(m_items[0].key >> (pass * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        std::uint32_t offset = 0;
+        for (std::uint32_t& bucket : histogram) {
+            std::uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for (const SortItem& item : m_items) {
+            m_scratch[histogram[(item.key >> (pass * 8)) & 0xFF]++] = item;
+        }
+        m_items.swap(m_scratch);
+    }
+}
+
+void RenderQueue::countChanges(size_t& programs, size_t& meshes, size_t& textures, bool sorted) const {
+    programs = meshes = textures = 0;
+    const RenderPacket* previous = nullptr;
+    for (size_t i = 0; i < m_packets.size(); i++) {
+        const RenderPacket& packet = m_packets[sorted ? m_items[i].packet : i];
+        programs += !previous || previous->pipeline != packet.pipeline;
+        meshes += !previous || previous->mesh != packet.mesh;
+        textures += !previous || previous->texture != packet.texture;
+        previous = &packet;
+    }
+}
+
+void RenderQueue::execute(StreamingBuffer* stream) {
+    m_stats = Stats{};
+    m_stats.packets = m_packets.size();
+    if (m_packets.empty()) {
+        return;
+    }
+    sort();
+
+    size_t programs, meshes, textures;
+    countChanges(programs, meshes, textures, false);
+    countChanges(m_stats.programChanges, m_stats.meshChanges, m_stats.textureChanges, true);
+    m_stats.programChangesAvoided = programs - std::min(programs, m_stats.programChanges);
+    m_stats.meshChangesAvoided = meshes - std::min(meshes, m_stats.meshChanges);
+    m_stats.textureChangesAvoided = textures - std::min(textures, m_stats.textureChanges);
+
+    // Every run is found and written before the first draw, so a stream without persistent mapping
+    // uploads them all with a single flush.
+    m_runs.clear();
+    for (size_t runStart = 0; runStart < m_items.size();) {
+        const RenderPacket& first = m_packets[m_items[runStart].packet];
+        size_t runEnd = runStart + 1;
+        while (runEnd < m_items.size()) {
+            const RenderPacket& packet = m_packets[m_items[runEnd].packet];
+            if (packet.pipeline != first.pipeline || packet.mesh != first.mesh || packet.texture != first.texture) {
+                break;
+            }
+            runEnd++;
+        }
+
+        Run run{ runStart, runEnd, {} };
+        if (stream) {
+            run.allocation = stream->allocateElements(runEnd - runStart, sizeof(InstanceData));
+        }
+        if (run.allocation) {
+            InstanceData* instances = static_cast<InstanceData*>(run.allocation.data);
+            for (size_t i = runStart; i < runEnd; i++) {
+                instances[i - runStart] = m_packets[m_items[i].packet].instance;
+            }
+        }
+        m_runs.push_back(run);
+        runStart = runEnd;
+    }
+    if (stream) {
+        stream->flush();
+    }
+
+    for (const Run& run : m_runs) {
+        // Runs are sorted by state, so the cache skips whatever the previous run already bound.
+        const RenderPacket& first = m_packets[m_items[run.begin].packet];
+        first.pipeline->use();
+        GLStateCache::bindTexture(0, GL_TEXTURE_2D, first.texture);
+        if (run.allocation) {
+            first.mesh->drawInstanced(*stream, run.allocation, run.end - run.begin);
+        }
+        else {
+            m_instances.clear();
+            for (size_t i = run.begin; i < run.end; i++) {
+                m_instances.push_back(m_packets[m_items[i].packet].instance);
+            }
+            first.mesh->drawInstanced(m_instances);
+            m_stats.fallbackDraws++;
+        }
+        m_stats.drawCalls++;
+        m_stats.uploadBytes += (run.end - run.begin) * sizeof(InstanceData);
+    }
+}
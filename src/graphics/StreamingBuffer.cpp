@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "graphics/StreamingBuffer.h"
+#include "graphics/GLStateCache.h"
+
+StreamingBuffer::StreamingBuffer(GLenum target, size_t regionSize, size_t regionCount)
+    : m_target(target), m_regionSize(regionSize), m_regionCount(std::max<size_t>(regionCount, 1)),
+    m_fences(m_regionCount, nullptr), m_region(m_regionCount - 1) {
+    // Keep every region start aligned for any offset alignment the driver might ask for.
+    m_regionSize = (m_regionSize + 255) & ~size_t(255);
+    GLsizeiptr totalSize = static_cast<GLsizeiptr>(m_regionSize * m_regionCount);
+
+    // All management goes through the copy-write binding: binding an element array buffer here would
+    // attach it to whatever VAO is currently bound.
+    glGenBuffers(1, &m_buffer);
+    GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    m_persistent = GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr;
+    if (m_persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        m_mapped = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+        if (!m_mapped) {
+            LOG_ERROR("StreamingBuffer::StreamingBuffer: Persistent mapping of buffer {} failed.", m_buffer);
+        }
+    }
+    else {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+        m_shadow.resize(static_cast<size_t>(totalSize));
+        m_mapped = m_shadow.data();
+    }
+    LOG_INFO("StreamingBuffer::StreamingBuffer: Buffer {} with {} regions of {} bytes ({}).", m_buffer, m_regionCount,
+        m_regionSize, m_persistent ? "persistent mapping" : "glBufferSubData fallback");
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    for (GLsync& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (m_buffer != 0) {
+        if (m_persistent && m_mapped) {
+            GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        GLStateCache::onBufferDeleted(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void StreamingBuffer::waitForRegion(size_t region) {
+    GLsync& fence = m_fences[region];
+    if (!fence) {
+        return;
+    }
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        m_stalls++;
+        // Flush once so the fence is guaranteed to signal, then block in 1ms steps.
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do {
+            result = glClientWaitSync(fence, flags, 1000000);
+            flags = 0;
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    if (result == GL_WAIT_FAILED) {
+        LOG_ERROR("StreamingBuffer::waitForRegion: glClientWaitSync failed for buffer {}.", m_buffer);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamingBuffer::beginFrame() {
+    if (m_inFrame) {
+        LOG_WARN("StreamingBuffer::beginFrame: Previous frame of buffer {} was not ended.", m_buffer);
+        endFrame();
+    }
+    m_region = (m_region + 1) % m_regionCount;
+    waitForRegion(m_region);
+    m_used = 0;
+    m_flushed = 0;
+    m_inFrame = true;
+}
+
+StreamingBuffer::Allocation StreamingBuffer::allocate(size_t size, size_t alignment) {
+    if (!m_inFrame || !m_mapped) {
+        LOG_ERROR("StreamingBuffer::allocate: Buffer {} is not between beginFrame() and endFrame().", m_buffer);
+        return {};
+    }
+    size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+    if (start + size > m_regionSize) {
+        return {};
+    }
+    m_used = start + size;
+
+    size_t offset = m_region * m_regionSize + start;
+    return Allocation{ m_mapped + offset, static_cast<GLintptr>(offset) };
+}
+
+StreamingBuffer::Allocation StreamingBuffer::allocateElements(size_t count, size_t stride) {
+    if (!m_inFrame || !m_mapped) {
+        LOG_ERROR("StreamingBuffer::allocateElements: Buffer {} is not between beginFrame() and endFrame().", m_buffer);
+        return {};
+    }
+    size_t regionStart = m_region * m_regionSize;
+    size_t start = (regionStart + m_used + stride - 1) / stride * stride - regionStart;
+    if (start + count * stride > m_regionSize) {
+        return {};
+    }
+    m_used = start + count * stride;
+
+    size_t offset = regionStart + start;
+    return Allocation{ m_mapped + offset, static_cast<GLintptr>(offset) };
+}
+
+size_t StreamingBuffer::getUniformOffsetAlignment() {
+    static size_t s_alignment = [] {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return static_cast<size_t>(std::max(alignment, 16));
+    }();
+    return s_alignment;
+}
+
+void StreamingBuffer::flush() {
+    if (m_persistent || !m_inFrame || m_flushed >= m_used) {
+        return;
+    }
+    size_t offset = m_region * m_regionSize + m_flushed;
+    GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(m_used - m_flushed), m_shadow.data() + offset);
+    GLStateCache::recordCall();
+    m_flushed = m_used;
+}
+
+void StreamingBuffer::endFrame() {
+    if (!m_inFrame) {
+        return;
+    }
+    if (!m_persistent && m_flushed < m_used) {
+        // Draws issued before now could not have seen these bytes.
+        LOG_WARN("StreamingBuffer::endFrame: Buffer {} has {} bytes that were never flushed.", m_buffer, m_used - m_flushed);
+    }
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GLStateCache::recordCall();
+    m_inFrame = false;
+}
@@ -12,7 +12,44 @@
 
 
 
-int main() {
+int main(int argc, char** argv) {
+	// --headless runs the simulation without a window or GL context. --ticks N runs N ticks as fast as
+	// possible and reports ticks per second; without it a headless game ticks in real time.
+	bool headless = false;
+	std::uint64_t ticks = 0;
+	size_t threads = 0;
+	size_t entities = 0;
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--ticks" && hasValue) {
+			ticks = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--threads" && hasValue) {
+			threads = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--entities" && hasValue) {
+			entities = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+		}
+		else {
+			LOG_ERROR("Unknown or incomplete argument: {}", arg);
+			return 1;
+		}
+	}
+
+	if (headless) {
+		LOG_INFO("Starting the game headless...");
+		Game game{};
+		game.initHeadless(threads);
+		game.spawnTestEntities(entities);
+		game.runHeadless(ticks);
+		game.cleanup();
+		return 0;
+	}
+
 	LOG_INFO("Starting the game...");	
 
 	// Initialize the window
@@ -20,6 +57,7 @@ int main() {
 	Game game{};
 
 	game.init(window.getGLFWWindow());
+	game.spawnTestEntities(entities);
 	game.run();
 	game.cleanup();
     return 0;
@@ -0,0 +1,25 @@
+#pragma once
+#include "pch.h"
+
+// Minimal assertion helpers for the headless test executables. A failed CHECK prints the condition and
+// location and is counted; each test's main() returns the count, so ctest reports any failure.
+inline int& checkFailureCount() {
+    static int s_failures = 0;
+    return s_failures;
+}
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition "\n";     \
+            checkFailureCount()++;                                                              \
+        }                                                                                       \
+    } while (false)
+
+// Runs one test function and reports its name if it added failures.
+#define RUN_TEST(test)                                                                          \
+    do {                                                                                        \
+        int before = checkFailureCount();                                                       \
+        test();                                                                                 \
+        std::cout << (checkFailureCount() == before ? "[ ok ] " : "[FAIL] ") << #test "\n";     \
+    } while (false)
@@ -0,0 +1,305 @@
+#include "pch.h"
+#include "ecs/World.h"
+#include "ecs/CommandBuffer.h"
+#include "ecs/TransformSystem.h"
+#include "Check.h"
+
+// parallelForEach and concurrently scheduled systems must produce the same results as a serial run.
+
+struct Value { std::int64_t value; };
+struct Doubled { std::int64_t value; };
+struct Counter { std::int64_t value; };
+struct Pooled {
+    static constexpr ComponentStorage Storage = ComponentStorage::SparseSet;
+    std::int64_t value;
+};
+
+static std::int64_t sumOf(World& world) {
+    std::int64_t sum = 0;
+    world.forEach<const Doubled>([&](EntityID, const Doubled& doubled) { sum += doubled.value; });
+    return sum;
+}
+
+static void testParallelForEachMatchesSerial() {
+    for (bool deterministic : { false, true }) {
+        World world;
+        world.setJobSystem(std::make_shared<JobSystem>(4));
+        world.setDeterministic(deterministic);
+        const std::int64_t count = 100000;
+        for (std::int64_t i = 0; i < count; i++) {
+            EntityID entity = world.createEntity();
+            world.addComponent<Value>(entity, Value{ i });
+            world.addComponent<Doubled>(entity, Doubled{ 0 });
+            // Spread the entities over several archetypes.
+            if (i % 3 == 0) {
+                world.addComponent<Counter>(entity, Counter{ 0 });
+            }
+        }
+
+        world.parallelForEach<const Value, Doubled>([](EntityID, const Value& value, Doubled& doubled) {
+            doubled.value = value.value * 2;
+        });
+        CHECK(sumOf(world) == count * (count - 1));
+
+        std::atomic<std::int64_t> visited{ 0 };
+        world.parallelForEach<const Value, Counter>([&](EntityID, const Value&, Counter& counter) {
+            counter.value++;
+            visited.fetch_add(1, std::memory_order_relaxed);
+        });
+        CHECK(visited.load() == (count + 2) / 3);
+    }
+}
+
+static void testSparseParallelForEach() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    const std::int64_t count = 20000;
+    for (std::int64_t i = 0; i < count; i++) {
+        EntityID entity = world.createEntity();
+        world.addComponent<Value>(entity, Value{ i });
+        if (i % 2 == 0) {
+            world.addComponent<Pooled>(entity, Pooled{ 0 });
+        }
+    }
+
+    world.parallelForEach<const Value, Pooled>([](EntityID, const Value& value, Pooled& pooled) {
+        pooled.value = value.value;
+    });
+    std::int64_t sum = 0;
+    size_t visited = 0;
+    world.forEach<const Pooled>([&](EntityID, const Pooled& pooled) {
+        sum += pooled.value;
+        visited++;
+    });
+    CHECK(visited == static_cast<size_t>(count / 2));
+    CHECK(sum == (count / 2) * (count - 2) / 2);
+}
+
+// Three systems with disjoint writes run concurrently; the fourth reads all of them and so must run last.
+template<typename T>
+struct IncrementSystem : ISystem {
+    void update(float, World& world) override {
+        world.forEach<T>([](EntityID, T& component) { component.value++; });
+    }
+    SystemAccess getAccess() const override { return SystemAccess().write<T>(); }
+};
+
+struct SumSystem : ISystem {
+    std::int64_t total = 0;
+    void update(float, World& world) override {
+        total = 0;
+        world.forEach<const Value, const Doubled, const Counter>([&](EntityID, const Value& a, const Doubled& b, const Counter& c) {
+            total += a.value + b.value + c.value;
+        });
+    }
+    SystemAccess getAccess() const override { return SystemAccess().read<Value, Doubled, Counter>(); }
+};
+
+static void testConcurrentSystems() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    for (int i = 0; i < 1000; i++) {
+        EntityID entity = world.createEntity();
+        world.addComponent<Value>(entity, Value{ 0 });
+        world.addComponent<Doubled>(entity, Doubled{ 0 });
+        world.addComponent<Counter>(entity, Counter{ 0 });
+    }
+    world.addSystem<IncrementSystem<Value>>();
+    world.addSystem<IncrementSystem<Doubled>>();
+    world.addSystem<IncrementSystem<Counter>>();
+    auto sum = world.addSystem<SumSystem>();
+
+    for (int frame = 1; frame <= 10; frame++) {
+        world.update(0.016f);
+        CHECK(sum->total == 3 * 1000 * frame);
+    }
+}
+
+// Concurrent systems whose parallel chunks write a component outside the iterated query. A thread
+// waiting in one system runs the other's chunks, which must still see their own system's access and
+// tick, and the shared column / pool ticks must end up raised.
+template<typename Read, typename Write>
+struct ScatterSystem : ISystem {
+    void update(float, World& world) override {
+        world.parallelForEach<const Read>([&](EntityID entity, const Read&) {
+            world.getComponent<Write>(entity)->value++;
+        });
+    }
+    SystemAccess getAccess() const override { return SystemAccess().template read<Read>().template write<Write>(); }
+};
+
+static void testSystemContextInChunks() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    const size_t count = 20000;
+    for (size_t i = 0; i < count; i++) {
+        EntityID entity = world.createEntity();
+        world.addComponent<Value>(entity, Value{ 0 });
+        world.addComponent<Doubled>(entity, Doubled{ 0 });
+        world.addComponent<Counter>(entity, Counter{ 0 });
+        world.addComponent<Pooled>(entity, Pooled{ 0 });
+    }
+    world.addSystem<ScatterSystem<Value, Counter>>();
+    world.addSystem<ScatterSystem<Doubled, Pooled>>();
+
+    for (int frame = 1; frame <= 5; frame++) {
+        Tick before = world.getChangeTick();
+        world.update(0.016f);
+        size_t counters = 0;
+        size_t pooled = 0;
+        world.query<const Counter>().forEach(Changed<Counter>{ before }, [&](EntityID, const Counter& counter) {
+            counters += counter.value == frame;
+        });
+        world.query<const Pooled>().forEach(Changed<Pooled>{ before }, [&](EntityID, const Pooled& value) {
+            pooled += value.value == frame;
+        });
+        CHECK(counters == count);
+        CHECK(pooled == count);
+    }
+}
+
+// In deterministic mode, commands from different chunks for the same entity play back in chunk order.
+static void testDeterministicCommandOrder() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    world.setDeterministic(true);
+    const size_t count = 1000;
+    std::vector<EntityID> entities;
+    for (size_t i = 0; i < count; i++) {
+        entities.push_back(world.createEntity());
+    }
+
+    CommandBuffer& commands = world.getCommandBuffer();
+    for (int round = 0; round < 5; round++) {
+        // Item j and item j + count both set entity j; the second lives in a later chunk.
+        world.parallelFor(2 * count, 16, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; j++) {
+                commands.add<Counter>(entities[j % count], Counter{ static_cast<std::int64_t>(j) });
+            }
+        });
+        world.update(0.016f);
+        size_t ordered = 0;
+        for (size_t i = 0; i < count; i++) {
+            ordered += world.getComponent<Counter>(entities[i])->value == static_cast<std::int64_t>(i + count);
+        }
+        CHECK(ordered == count);
+    }
+}
+
+// Concurrent systems recording deferred destruction; playback must apply every command exactly once.
+struct CullSystem : ISystem {
+    void update(float, World& world) override {
+        CommandBuffer& commands = world.getCommandBuffer();
+        world.parallelForEach<const Value>([&](EntityID entity, const Value& value) {
+            if (value.value % 2 == 1) {
+                commands.destroy(entity);
+            }
+        });
+    }
+    SystemAccess getAccess() const override { return SystemAccess().read<Value>(); }
+};
+
+static void testCommandsFromWorkers() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    for (int i = 0; i < 10000; i++) {
+        world.addComponent<Value>(world.createEntity(), Value{ i });
+    }
+    world.addSystem<CullSystem>();
+    world.update(0.016f);
+    CHECK(world.getEntityCount() == 5000);
+}
+
+static void testTransformPropagation() {
+    World world;
+    world.setJobSystem(std::make_shared<JobSystem>(4));
+    world.addSystem<TransformSystem>();
+
+    // Enough roots and children to take the parallel path.
+    std::vector<EntityID> roots;
+    for (int r = 0; r < 200; r++) {
+        EntityID root = world.createEntity();
+        LocalTransform transform;
+        transform.position = glm::vec3(static_cast<float>(r), 0.0f, 0.0f);
+        world.addComponent<LocalTransform>(root, transform);
+        world.addComponent<WorldTransform>(root);
+        EntityID parent = root;
+        for (int depth = 0; depth < 30; depth++) {
+            EntityID child = world.createEntity();
+            LocalTransform local;
+            local.position = glm::vec3(0.0f, 1.0f, 0.0f);
+            world.addComponent<LocalTransform>(child, local);
+            world.addComponent<WorldTransform>(child);
+            Hierarchy::setParent(world, child, parent);
+            parent = child;
+        }
+        roots.push_back(root);
+    }
+    world.update(0.016f);
+
+    size_t wrong = 0;
+    const World& view = world;
+    view.forEach<const Parent, const WorldTransform>([&](EntityID, const Parent& parent, const WorldTransform& transform) {
+        const WorldTransform* parentTransform = view.getComponent<WorldTransform>(parent.entity);
+        glm::vec4 expected = parentTransform->matrix * glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+        wrong += glm::length(transform.matrix[3] - expected) < 1e-3f ? 0 : 1;
+    });
+    CHECK(wrong == 0);
+}
+
+static EntityID spawnTransform(World& world, glm::vec3 position) {
+    EntityID entityID = world.createEntity();
+    LocalTransform local;
+    local.position = position;
+    world.addComponent<LocalTransform>(entityID, local);
+    world.addComponent<WorldTransform>(entityID);
+    return entityID;
+}
+
+static glm::vec3 worldPosition(const World& world, EntityID entityID) {
+    return glm::vec3(world.getComponent<WorldTransform>(entityID)->matrix[3]);
+}
+
+static void testTransformHierarchyEdits() {
+    World world;
+    world.addSystem<TransformSystem>();
+
+    EntityID doomed = spawnTransform(world, glm::vec3(5.0f, 0.0f, 0.0f));
+    EntityID orphan = spawnTransform(world, glm::vec3(0.0f, 1.0f, 0.0f));
+    Hierarchy::setParent(world, orphan, doomed);
+    EntityID holder = spawnTransform(world, glm::vec3(10.0f, 0.0f, 0.0f));
+    EntityID detached = spawnTransform(world, glm::vec3(0.0f, 2.0f, 0.0f));
+    Hierarchy::setParent(world, detached, holder);
+    EntityID other = spawnTransform(world, glm::vec3(0.0f, 0.0f, 3.0f));
+    EntityID otherChild = spawnTransform(world, glm::vec3(1.0f, 0.0f, 0.0f));
+    Hierarchy::setParent(world, otherChild, other);
+    world.update(0.016f);
+    CHECK(glm::length(worldPosition(world, orphan) - glm::vec3(5.0f, 1.0f, 0.0f)) < 1e-4f);
+    CHECK(glm::length(worldPosition(world, detached) - glm::vec3(10.0f, 2.0f, 0.0f)) < 1e-4f);
+
+    // Destroyed without going through Hierarchy: the child has to become a root on the next run anyway.
+    world.destroyEntity(doomed);
+    world.update(0.016f);
+    CHECK(glm::length(worldPosition(world, orphan) - glm::vec3(0.0f, 1.0f, 0.0f)) < 1e-4f);
+
+    Hierarchy::removeParent(world, detached);
+    world.update(0.016f);
+    CHECK(glm::length(worldPosition(world, detached) - glm::vec3(0.0f, 2.0f, 0.0f)) < 1e-4f);
+
+    // The untouched subtree kept its matrices across the rebuild, so a partial run still composes correctly.
+    world.getComponent<LocalTransform>(otherChild)->position = glm::vec3(2.0f, 0.0f, 0.0f);
+    world.update(0.016f);
+    CHECK(glm::length(worldPosition(world, otherChild) - glm::vec3(2.0f, 0.0f, 3.0f)) < 1e-4f);
+}
+
+int main() {
+    RUN_TEST(testParallelForEachMatchesSerial);
+    RUN_TEST(testSparseParallelForEach);
+    RUN_TEST(testConcurrentSystems);
+    RUN_TEST(testSystemContextInChunks);
+    RUN_TEST(testDeterministicCommandOrder);
+    RUN_TEST(testCommandsFromWorkers);
+    RUN_TEST(testTransformPropagation);
+    RUN_TEST(testTransformHierarchyEdits);
+    return checkFailureCount();
+}
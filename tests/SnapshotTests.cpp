@@ -0,0 +1,301 @@
+#include "pch.h"
+#include "ecs/World.h"
+#include "ecs/Hierarchy.h"
+#include "Check.h"
+
+// Snapshot and delta round trips: the restored World must hold the same entities under the same
+// handles with the same component values as the source.
+
+struct Health { int value; };
+struct Label { std::string text; };
+struct Frozen {};
+struct Score {
+    static constexpr ComponentStorage Storage = ComponentStorage::SparseSet;
+    int value;
+};
+
+template<>
+struct ComponentSerializer<Label> {
+    static void write(SnapshotWriter& out, const Label& value) { out.writeString(value.text); }
+    static Label read(SnapshotReader& in) { return Label{ in.readString() }; }
+};
+
+static void registerComponents() {
+    SnapshotRegistry::registerComponent<Health>("Health");
+    SnapshotRegistry::registerComponent<Label>("Label");
+    SnapshotRegistry::registerComponent<Frozen>("Frozen");
+    SnapshotRegistry::registerComponent<Score>("Score");
+    Hierarchy::registerSnapshotComponents();
+}
+
+static std::vector<EntityID> populate(World& world, int count) {
+    std::vector<EntityID> entities;
+    for (int i = 0; i < count; i++) {
+        EntityID entity = world.createEntity();
+        world.addComponent<Health>(entity, Health{ i });
+        if (i % 2 == 0) {
+            world.addComponent<Label>(entity, Label{ "label " + std::to_string(i) });
+        }
+        if (i % 3 == 0) {
+            world.addComponent<Score>(entity, Score{ i * 10 });
+        }
+        if (i % 4 == 0) {
+            world.addComponent<Frozen>(entity);
+        }
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+// True if both Worlds hold the same entities with the same registered component values.
+static bool sameContents(const World& a, const World& b) {
+    std::vector<EntityID> entities = a.getAllEntities();
+    if (entities.size() != b.getEntityCount()) {
+        return false;
+    }
+    for (EntityID entity : entities) {
+        if (!b.isValidEntity(entity)) {
+            return false;
+        }
+        const Health* ha = a.getComponent<Health>(entity);
+        const Health* hb = b.getComponent<Health>(entity);
+        const Label* la = a.getComponent<Label>(entity);
+        const Label* lb = b.getComponent<Label>(entity);
+        const Score* sa = a.getComponent<Score>(entity);
+        const Score* sb = b.getComponent<Score>(entity);
+        if ((ha == nullptr) != (hb == nullptr) || (ha && ha->value != hb->value)
+            || (la == nullptr) != (lb == nullptr) || (la && la->text != lb->text)
+            || (sa == nullptr) != (sb == nullptr) || (sa && sa->value != sb->value)
+            || a.hasComponent<Frozen>(entity) != b.hasComponent<Frozen>(entity)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSnapshotRoundTrip() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 200);
+    source.destroyEntity(entities[10]);
+    source.destroyEntity(entities[11]);
+
+    SnapshotWriter writer;
+    source.writeSnapshot(writer);
+    World loaded;
+    SnapshotReader reader(writer.getBuffer().data(), writer.size());
+    CHECK(loaded.readSnapshot(reader));
+    CHECK(sameContents(source, loaded));
+    CHECK(!loaded.isValidEntity(entities[10]));
+
+    // A truncated snapshot is rejected and leaves the World empty.
+    World truncated;
+    SnapshotReader shortReader(writer.getBuffer().data(), writer.size() / 2);
+    CHECK(!truncated.readSnapshot(shortReader));
+    CHECK(truncated.getEntityCount() == 0);
+}
+
+static void testRestoreSnapshotRollsBack() {
+    World world;
+    std::vector<EntityID> entities = populate(world, 100);
+    WorldSnapshot snapshot = world.captureSnapshot();
+
+    World reference;
+    CHECK(reference.restoreSnapshot(snapshot));
+
+    world.getComponent<Health>(entities[5])->value = -1;
+    world.destroyEntity(entities[6]);
+    world.removeComponent<Label>(entities[8]);
+    world.addComponent<Score>(entities[9], Score{ 99 });
+    world.createEntity();
+
+    CHECK(world.restoreSnapshot(snapshot));
+    CHECK(sameContents(reference, world));
+}
+
+static void testDeltaRoundTrip() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 300);
+    WorldSnapshot base = source.captureSnapshot();
+    World replica;
+    CHECK(replica.restoreSnapshot(base));
+
+    source.getComponent<Health>(entities[1])->value = 1000;
+    source.getComponent<Label>(entities[2])->text = "renamed";
+    source.getComponent<Score>(entities[3])->value = 7;
+    source.destroyEntity(entities[4]);
+    source.removeComponent<Frozen>(entities[8]);
+    source.addComponent<Label>(entities[7], Label{ "new label" });
+    EntityID created = source.createEntity();
+    source.addComponent<Health>(created, Health{ 5 });
+
+    WorldDelta delta = source.diff(base);
+    CHECK(replica.applyDelta(delta));
+    CHECK(sameContents(source, replica));
+    CHECK(replica.getComponent<Label>(entities[2])->text == "renamed");
+
+    // A second delta chained onto the first.
+    WorldSnapshot next = source.captureSnapshot();
+    source.getComponent<Health>(entities[1])->value = 2000;
+    source.destroyEntity(created);
+    CHECK(replica.applyDelta(source.diff(next)));
+    CHECK(sameContents(source, replica));
+}
+
+static void testDeltaSkipsUnchangedValues() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 1000);
+    WorldSnapshot base = source.captureSnapshot();
+    WorldDelta empty = source.diff(base);
+
+    source.getComponent<Health>(entities[500])->value = 1;
+    WorldDelta single = source.diff(base);
+    CHECK(single.data.size() > empty.data.size());
+    CHECK(single.data.size() < empty.data.size() + 64);
+}
+
+// After any round trip the copy must hand out the same handles as the source, in the same order, or
+// replays diverge as soon as they create an entity.
+static bool sameNextEntities(World& a, World& b, int count) {
+    for (int i = 0; i < count; i++) {
+        if (a.createEntity() != b.createEntity()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testEntityIDContinuity() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 10);
+    // Free slots out of index order: LIFO recycling hands out entities[3]'s slot first.
+    source.destroyEntity(entities[1]);
+    source.destroyEntity(entities[7]);
+    source.destroyEntity(entities[3]);
+
+    WorldSnapshot snapshot = source.captureSnapshot();
+    SnapshotWriter writer;
+    source.writeSnapshot(writer);
+
+    World restored;
+    CHECK(restored.restoreSnapshot(snapshot));
+    World rolledBack;
+    populate(rolledBack, 20);
+    CHECK(rolledBack.restoreSnapshot(snapshot));
+    World loaded;
+    SnapshotReader reader(writer.getBuffer().data(), writer.size());
+    CHECK(loaded.readSnapshot(reader));
+    World replica;
+    CHECK(replica.restoreSnapshot(snapshot));
+
+    // Deltas carry the free list as well.
+    source.destroyEntity(entities[0]);
+    source.destroyEntity(entities[9]);
+    source.createEntity();
+    CHECK(replica.applyDelta(source.diff(snapshot)));
+    CHECK(sameNextEntities(source, replica, 6));
+
+    CHECK(getEntityIndex(restored.createEntity()) == getEntityIndex(entities[3]));
+    CHECK(getEntityIndex(rolledBack.createEntity()) == getEntityIndex(entities[3]));
+    CHECK(getEntityIndex(loaded.createEntity()) == getEntityIndex(entities[3]));
+    for (int i = 0; i < 4; i++) {
+        EntityID next = restored.createEntity();
+        CHECK(rolledBack.createEntity() == next);
+        CHECK(loaded.createEntity() == next);
+    }
+}
+
+// Captures inside an exclusive system, then keeps writing in the same update.
+class CaptureSystem : public ISystem {
+public:
+    EntityID entity = NULL_ENTITY_ID;
+    WorldSnapshot snapshot;
+
+    void update(float, World& world) override {
+        world.getComponent<Health>(entity)->value = 1;
+        snapshot = world.captureSnapshot();
+        world.getComponent<Health>(entity)->value = 2;
+    }
+};
+
+static void testCaptureInsideSystem() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 10);
+    auto system = source.addSystem<CaptureSystem>();
+    system->entity = entities[5];
+    source.update(0.016f);
+
+    World replica;
+    CHECK(replica.restoreSnapshot(system->snapshot));
+    CHECK(replica.applyDelta(source.diff(system->snapshot)));
+    CHECK(replica.getComponent<Health>(entities[5])->value == 2);
+    CHECK(sameContents(source, replica));
+}
+
+static void testDiffBetweenSnapshots() {
+    World source;
+    std::vector<EntityID> entities = populate(source, 50);
+    source.destroyEntity(entities[20]);
+    WorldSnapshot from = source.captureSnapshot();
+
+    source.getComponent<Health>(entities[1])->value = 1000;
+    source.getComponent<Label>(entities[2])->text = "renamed";
+    source.getComponent<Score>(entities[3])->value = 7;
+    source.destroyEntity(entities[4]);
+    source.removeComponent<Frozen>(entities[8]);
+    source.addComponent<Label>(entities[7], Label{ "new label" });
+    source.addComponent<Health>(source.createEntity(), Health{ 5 });
+    source.addComponent<Health>(source.createEntity(), Health{ 6 });
+    WorldSnapshot to = source.captureSnapshot();
+
+    World replica;
+    CHECK(replica.restoreSnapshot(from));
+    WorldDelta delta = World::diff(from, to);
+    CHECK(delta.since == from.tick && delta.until == to.tick);
+    CHECK(replica.applyDelta(delta));
+    CHECK(sameContents(source, replica));
+    CHECK(sameNextEntities(source, replica, 4));
+
+    // Only what differs is sent.
+    CHECK(World::diff(to, to).data.size() < delta.data.size());
+    CHECK(World::diff(from, from).data.size() < 64);
+
+    // Backwards, including slots the earlier state never used.
+    World rewound;
+    CHECK(rewound.restoreSnapshot(to));
+    CHECK(rewound.applyDelta(World::diff(to, from)));
+    World original;
+    CHECK(original.restoreSnapshot(from));
+    CHECK(sameContents(original, rewound));
+    CHECK(sameNextEntities(original, rewound, 4));
+}
+
+static void testHierarchySurvivesSnapshot() {
+    World world;
+    EntityID parent = world.createEntity();
+    EntityID child = world.createEntity();
+    world.addComponent<LocalTransform>(parent);
+    world.addComponent<LocalTransform>(child);
+    Hierarchy::setParent(world, child, parent);
+
+    SnapshotWriter writer;
+    world.writeSnapshot(writer);
+    World loaded;
+    SnapshotReader reader(writer.getBuffer().data(), writer.size());
+    CHECK(loaded.readSnapshot(reader));
+    CHECK(Hierarchy::getParent(loaded, child) == parent);
+    const Children* children = loaded.getComponent<Children>(parent);
+    CHECK(children && children->entities.size() == 1 && children->entities[0] == child);
+}
+
+int main() {
+    registerComponents();
+    RUN_TEST(testSnapshotRoundTrip);
+    RUN_TEST(testRestoreSnapshotRollsBack);
+    RUN_TEST(testDeltaRoundTrip);
+    RUN_TEST(testDeltaSkipsUnchangedValues);
+    RUN_TEST(testEntityIDContinuity);
+    RUN_TEST(testCaptureInsideSystem);
+    RUN_TEST(testDiffBetweenSnapshots);
+    RUN_TEST(testHierarchySurvivesSnapshot);
+    return checkFailureCount();
+}
@@ -0,0 +1,192 @@
+#include "pch.h"
+#include "ecs/World.h"
+#include "ecs/CommandBuffer.h"
+#include "Check.h"
+
+// Structural changes must never lose or mix up component data: every operation below moves rows
+// between archetype tables or swap-removes them, and the checks compare against a plain reference map.
+
+struct Position { float x, y; };
+struct Velocity { float dx, dy; };
+struct Name { std::string value; };
+struct Marker {};
+struct NameCopy { Name name; };
+struct Sparse {
+    static constexpr ComponentStorage Storage = ComponentStorage::SparseSet;
+    int value;
+};
+
+struct Expected {
+    float x;
+    bool hasVelocity;
+    bool hasSparse;
+};
+
+static bool matches(const World& world, EntityID entity, const Expected& expected) {
+    const Position* position = world.getComponent<Position>(entity);
+    const Name* name = world.getComponent<Name>(entity);
+    const Velocity* velocity = world.getComponent<Velocity>(entity);
+    const Sparse* sparse = world.getComponent<Sparse>(entity);
+    return position && position->x == expected.x && position->y == -expected.x
+        && name && name->value == "entity " + std::to_string(static_cast<int>(expected.x))
+        && (velocity != nullptr) == expected.hasVelocity && (!velocity || velocity->dx == expected.x * 2)
+        && (sparse != nullptr) == expected.hasSparse && (!sparse || sparse->value == static_cast<int>(expected.x));
+}
+
+static void testAddRemoveDestroyKeepData() {
+    World world;
+    std::map<EntityID, Expected> expected;
+    for (int i = 0; i < 1000; i++) {
+        EntityID entity = world.createEntity();
+        float x = static_cast<float>(i);
+        world.addComponent<Position>(entity, Position{ x, -x });
+        world.addComponent<Name>(entity, Name{ "entity " + std::to_string(i) });
+        expected[entity] = Expected{ x, false, false };
+        if (i % 2 == 0) {
+            world.addComponent<Velocity>(entity, Velocity{ x * 2, 0.0f });
+            expected[entity].hasVelocity = true;
+        }
+        if (i % 3 == 0) {
+            world.addComponent<Sparse>(entity, Sparse{ i });
+            expected[entity].hasSparse = true;
+        }
+        if (i % 5 == 0) {
+            world.addComponent<Marker>(entity);
+        }
+    }
+
+    // Remove from and destroy in the middle of tables, so swap-removal relocates other rows.
+    int step = 0;
+    for (auto it = expected.begin(); it != expected.end(); step++) {
+        if (step % 7 == 0) {
+            world.destroyEntity(it->first);
+            CHECK(!world.isValidEntity(it->first));
+            it = expected.erase(it);
+            continue;
+        }
+        if (step % 4 == 0 && it->second.hasVelocity) {
+            world.removeComponent<Velocity>(it->first);
+            it->second.hasVelocity = false;
+        }
+        if (step % 6 == 0 && it->second.hasSparse) {
+            world.removeComponent<Sparse>(it->first);
+            it->second.hasSparse = false;
+        }
+        ++it;
+    }
+
+    CHECK(world.getEntityCount() == expected.size());
+    size_t mismatches = 0;
+    for (const auto& [entity, values] : expected) {
+        mismatches += matches(world, entity, values) ? 0 : 1;
+    }
+    CHECK(mismatches == 0);
+
+    size_t visited = 0;
+    world.forEach<const Position, const Name>([&](EntityID entity, const Position& position, const Name&) {
+        auto it = expected.find(entity);
+        CHECK(it != expected.end() && it->second.x == position.x);
+        visited++;
+    });
+    CHECK(visited == expected.size());
+}
+
+static void testHandlesAreGenerational() {
+    World world;
+    EntityID first = world.createEntity();
+    world.destroyEntity(first);
+    EntityID second = world.createEntity();
+    CHECK(getEntityIndex(first) == getEntityIndex(second));
+    CHECK(first != second);
+    CHECK(!world.isValidEntity(first));
+    CHECK(world.isValidEntity(second));
+    CHECK(world.getComponent<Position>(first) == nullptr);
+}
+
+static void testBulkCreateAndDestroy() {
+    World world;
+    std::vector<EntityID> entities = world.createEntities(500, Position{ 1.0f, 2.0f }, Velocity{ 3.0f, 4.0f });
+    CHECK(entities.size() == 500);
+    CHECK(world.getEntityCount() == 500);
+
+    std::vector<EntityID> destroyed(entities.begin(), entities.begin() + 200);
+    destroyed.push_back(destroyed.front());
+    world.destroyEntities(destroyed);
+    CHECK(world.getEntityCount() == 300);
+
+    size_t visited = 0;
+    world.forEach<const Position, const Velocity>([&](EntityID, const Position& position, const Velocity& velocity) {
+        CHECK(position.y == 2.0f && velocity.dy == 4.0f);
+        visited++;
+    });
+    CHECK(visited == 300);
+}
+
+static void testReservedEntities() {
+    World world;
+    EntityID recycled = world.createEntity();
+    world.destroyEntity(recycled);
+
+    std::vector<EntityID> reserved;
+    world.reserveEntities(3, reserved);
+    CHECK(reserved.size() == 3);
+    CHECK(!world.isValidEntity(reserved[0]));
+    world.flushReservedEntities();
+    for (EntityID entity : reserved) {
+        CHECK(world.isValidEntity(entity));
+    }
+    CHECK(world.getEntityCount() == 3);
+}
+
+// The new component's arguments may refer to the entity's own components, which the add relocates.
+static void testAddComponentFromOwnComponent() {
+    World world;
+    std::vector<EntityID> entities;
+    for (int i = 0; i < 8; i++) {
+        EntityID entity = world.createEntity();
+        world.addComponent<Name>(entity, Name{ "a name long enough to live on the heap " + std::to_string(i) });
+        entities.push_back(entity);
+    }
+    for (int i = 0; i < 8; i++) {
+        const Name& name = *world.getComponent<Name>(entities[i]);
+        NameCopy& copy = world.addComponent<NameCopy>(entities[i], name);
+        CHECK(copy.name.value == world.getComponent<Name>(entities[i])->value);
+    }
+    for (int i = 0; i < 8; i++) {
+        CHECK(world.getComponent<NameCopy>(entities[i])->name.value == "a name long enough to live on the heap " + std::to_string(i));
+    }
+}
+
+static void testCommandBufferPlayback() {
+    World world;
+    EntityID kept = world.createEntity();
+    EntityID dropped = world.createEntity();
+    world.addComponent<Position>(kept, Position{ 1.0f, 1.0f });
+    world.addComponent<Position>(dropped, Position{ 2.0f, 2.0f });
+
+    CommandBuffer& commands = world.getCommandBuffer();
+    world.forEach<const Position>([&](EntityID entity, const Position& position) {
+        if (position.x == 1.0f) {
+            commands.add<Velocity>(entity, Velocity{ 5.0f, 5.0f });
+        }
+        else {
+            commands.destroy(entity);
+        }
+    });
+    CHECK(!world.hasComponent<Velocity>(kept));
+    world.update(0.0f);
+
+    CHECK(world.isValidEntity(kept) && !world.isValidEntity(dropped));
+    const Velocity* velocity = world.getComponent<Velocity>(kept);
+    CHECK(velocity && velocity->dx == 5.0f);
+}
+
+int main() {
+    RUN_TEST(testAddRemoveDestroyKeepData);
+    RUN_TEST(testHandlesAreGenerational);
+    RUN_TEST(testBulkCreateAndDestroy);
+    RUN_TEST(testReservedEntities);
+    RUN_TEST(testAddComponentFromOwnComponent);
+    RUN_TEST(testCommandBufferPlayback);
+    return checkFailureCount();
+}